@@ -1,6 +1,357 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include "ai_system.hpp"
 #include "world_init.hpp"
+#include "flow_field.hpp"
+#include "coverage_map.hpp"
+#include "tower_types.hpp"
+
+// path segments looked at when solving an intercept, beyond that the shot is not taken
+const int INTERCEPT_MAX_SEGMENTS = 16;
+
+// Walk an invader's flow-field path at INVADER_SPEED from where it is now, recording each
+// turn with the time it gets there. Built at most once per invader per step and shared by
+// every tower aiming at it.
+int AISystem::forecast(Entity invader)
+{
+	auto [it, inserted] = forecast_index.emplace(invader.id(), (int)forecasts.size());
+	if (!inserted)
+		return it->second;
+
+	PathForecast f;
+	f.first = (int)forecast_points.size();
+	const Motion& motion = registry.motions.get(invader);
+	vec2 position = motion.position;
+	float time = 0.f;
+	forecast_points.push_back(position);
+	forecast_times.push_back(time);
+
+	if (!registry.flowCursors.has(invader) || !flow_field.ready()) {
+		// not following the field: extrapolate its current velocity
+		f.open_ended = true;
+		f.tail_velocity = motion.velocity;
+	}
+	else {
+		ivec2 cell = registry.flowCursors.get(invader).cell;
+		for (int segment = 0; segment < INTERCEPT_MAX_SEGMENTS; segment++) {
+			vec2 end = vec2(
+				cell.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f,
+				cell.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f
+			);
+			time += glm::distance(position, end) / INVADER_SPEED;
+			position = end;
+			forecast_points.push_back(position);
+			forecast_times.push_back(time);
+
+			// the path ends where it leaves through an exit (or gets stuck)
+			if (flow_field.is_exit(cell))
+				break;
+			// collinear tiles add nothing to the forecast, one segment per straight run
+			ivec2 next = flow_field.next_corner(cell);
+			if (next == cell)
+				break;
+			cell = next;
+		}
+	}
+	f.count = (int)forecast_points.size() - f.first;
+	forecasts.push_back(f);
+	return (int)forecasts.size() - 1;
+}
+
+// Time for a shot at shot_speed from shooter to meet the invader along its forecast.
+// Along each straight segment the invader moves linearly, so |start + v*t - shooter| =
+// shot_speed * t is a quadratic with exactly one non-negative root (the shot is faster
+// than the invader); the first segment containing it wins.
+// Returns false if the invader leaves the forecast (through an exit) first.
+bool AISystem::solve_intercept(vec2 shooter, float shot_speed, const PathForecast& f, vec2& hit_point, float& hit_time) const
+{
+	const int last = f.first + f.count - 1;
+	for (int i = f.first; i <= last; i++) {
+		const vec2 start = forecast_points[i];
+		const float start_time = forecast_times[i];
+		vec2 velocity;
+		float end_time;
+		if (i < last) {
+			end_time = forecast_times[i + 1];
+			velocity = end_time > start_time ? (forecast_points[i + 1] - start) / (end_time - start_time) : vec2(0, 0);
+		}
+		else if (f.open_ended) {
+			end_time = INFINITY;
+			velocity = f.tail_velocity;
+		}
+		else {
+			break;
+		}
+
+		vec2 w = start - velocity * start_time - shooter;
+		float a = dot(velocity, velocity) - shot_speed * shot_speed;
+		float b = 2.f * dot(w, velocity);
+		float c = dot(w, w);
+		float t = (-b - sqrt(b * b - 4.f * a * c)) / (2.f * a);
+		if (t <= end_time) {
+			hit_time = max(t, start_time);
+			hit_point = start + velocity * (hit_time - start_time);
+			return true;
+		}
+	}
+	return false;
+}
+
+// towers are aimed in batches of this size
+static const int AIM_BATCH = 64;
+
+// largest difference of aim_batch from the libm version it replaces (atan2, angle wrap
+// loops, cos/sin), in degrees for the new angle and per component for the shot direction;
+// checked on every batch in debug builds
+static const float AIM_TOLERANCE_DEG = 1e-3f;
+static const float AIM_TOLERANCE_DIR = 1e-5f;
+
+// one batch of towers in SoA form; separate arrays of one object, so the compiler
+// knows they do not alias and can vectorize aim_batch without runtime checks
+struct AimBatch
+{
+	float dx[AIM_BATCH], dy[AIM_BATCH];	// to the aim point
+	float angle[AIM_BATCH];
+	float new_angle[AIM_BATCH], dir_x[AIM_BATCH], dir_y[AIM_BATCH];
+};
+
+// a when c, otherwise b; a bitwise blend of two computed values instead of a branch
+// (the compiler will not if-convert float selects itself under the default trapping-math)
+static inline float blend(bool c, float a, float b)
+{
+	uint32_t ua, ub;
+	memcpy(&ua, &a, sizeof(float));
+	memcpy(&ub, &b, sizeof(float));
+	const uint32_t mask = 0u - (uint32_t)c;
+	const uint32_t blended = (ua & mask) | (ub & ~mask);
+	float result;
+	memcpy(&result, &blended, sizeof(float));
+	return result;
+}
+
+// nearest integer, without a libm call so loops using it stay vectorizable
+static inline float round_nearest(float x)
+{
+	return (float)(int)(x + blend(x < 0.f, -0.5f, 0.5f));
+}
+
+// atan2 from a minimax polynomial for atan on [0, 1] (error far below AIM_TOLERANCE_DEG)
+// and blends for the octant
+static inline float fast_atan2(float y, float x)
+{
+	const float ax = abs(x), ay = abs(y);
+	const bool steep = ay > ax;
+	const float t = blend(steep, ax, ay) / (blend(steep, ay, ax) + 1e-30f);	// 0/0 is 0
+	const float t2 = t * t;
+	float a = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+	a = blend(steep, (float)M_PI / 2.f - a, a);
+	a = blend(x < 0.f, (float)M_PI - a, a);
+	return blend(y < 0.f, -a, a);
+}
+
+// sin and cos from their Taylor series after reducing to [-pi/2, pi/2], where the
+// truncation error is below float precision
+static inline void fast_sincos(float angle, float& s, float& c)
+{
+	const float pi = (float)M_PI;
+	float x = angle - 2.f * pi * round_nearest(angle / (2.f * pi));
+	const bool folded = abs(x) > pi / 2.f;
+	x = blend(folded, blend(x < 0.f, -pi, pi) - x, x);	// sin(pi - x) = sin(x), cos(pi - x) = -cos(x)
+	const float x2 = x * x;
+	s = x * (1.f + x2 * (-1.f / 6.f + x2 * (1.f / 120.f + x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f + x2 * (-1.f / 39916800.f))))));
+	const float cx = 1.f + x2 * (-1.f / 2.f + x2 * (1.f / 24.f + x2 * (-1.f / 720.f + x2 * (1.f / 40320.f + x2 * (-1.f / 3628800.f + x2 * (1.f / 479001600.f))))));
+	c = blend(folded, -cx, cx);
+}
+
+// Turn and shot direction for the first count towers of a batch, branch-free so the
+// compiler can vectorize it. dx/dy point from the tower to the point it aims at (where
+// it leads its target); angles are
+// in degrees and mirrored like Motion::angle. The tower turns by at most max_turn
+// toward the target and snaps onto it when closer than that.
+static void aim_batch(int count, float max_turn, AimBatch& b)
+{
+    for (int k = 0; k < count; k++) {
+        const float desired = -fast_atan2(b.dy[k], b.dx[k]) * (180.f / (float)M_PI);
+        float delta = desired - b.angle[k];
+        // into [-180, 180] like the wrap loops did, an exact half turn keeps its sign
+        delta -= 360.f * (float)(int)(delta / 360.f);
+        delta += blend(delta < -180.f, 360.f, 0.f);
+        delta -= blend(delta > 180.f, 360.f, 0.f);
+        b.new_angle[k] = blend(abs(delta) < max_turn, desired, b.angle[k] + blend(delta > 0.f, max_turn, -max_turn));
+
+        float s, c;
+        fast_sincos(-b.new_angle[k] * ((float)M_PI / 180.f), s, c);
+        b.dir_x[k] = c;
+        b.dir_y[k] = s;
+    }
+}
+
+#ifndef NDEBUG
+// the scalar version aim_batch replaces, to check the approximations against
+static float aim_scalar(float dx, float dy, float angle, float max_turn, float& new_angle, vec2& dir)
+{
+	float desired = -glm::degrees(atan2(dy, dx));
+	float delta = desired - angle;
+	while (delta > 180.f)
+		delta -= 360.f;
+	while (delta < -180.f)
+		delta += 360.f;
+	new_angle = fabs(delta) < max_turn ? desired : angle + (delta > 0 ? max_turn : -max_turn);
+	float rad = glm::radians(-new_angle);
+	dir = { cos(rad), sin(rad) };
+	return delta;
+}
+#endif
+
+// Lead and aim the towers in aiming[begin, end) from their gathered inputs, filling their
+// result slots. Reads only AISystem arrays, so disjoint ranges can run on different workers.
+void AISystem::aim(size_t begin, size_t end, float max_turn)
+{
+	AimBatch batch;
+	for (size_t first = begin; first < end; first += AIM_BATCH) {
+		const int count = (int)std::min<size_t>(AIM_BATCH, end - first);
+		for (int k = 0; k < count; k++) {
+			const int t = aiming[first + k];
+
+			// lead the target: turn toward where a shot fired now would meet it
+			aim_has_intercept[t] = solve_intercept(tower_positions[t], tower_shot_speeds[t], forecasts[target_forecasts[t]],
+				aim_intercept[t], aim_intercept_time[t]);
+			const vec2 d = (aim_has_intercept[t] ? aim_intercept[t] : target_positions[t]) - tower_positions[t];
+			batch.dx[k] = d.x;
+			batch.dy[k] = d.y;
+			batch.angle[k] = tower_angles[t];
+		}
+		aim_batch(count, max_turn, batch);
+		for (int k = 0; k < count; k++) {
+			const int t = aiming[first + k];
+			aim_angle[t] = batch.new_angle[k];
+			aim_dir[t] = { batch.dir_x[k], batch.dir_y[k] };
+#ifndef NDEBUG
+			float ref_angle;
+			vec2 ref_dir;
+			const float ref_delta = aim_scalar(batch.dx[k], batch.dy[k], batch.angle[k], max_turn, ref_angle, ref_dir);
+			// a target straight behind can be turned toward either way
+			if (abs(ref_delta) > 180.f - AIM_TOLERANCE_DEG)
+				continue;
+			float angle_error = ref_angle - batch.new_angle[k];
+			angle_error -= 360.f * round_nearest(angle_error / 360.f);	// +-180 are the same heading
+			assert(abs(angle_error) <= AIM_TOLERANCE_DEG);
+			assert(abs(ref_dir.x - batch.dir_x[k]) <= AIM_TOLERANCE_DIR && abs(ref_dir.y - batch.dir_y[k]) <= AIM_TOLERANCE_DIR);
+#endif
+		}
+	}
+}
+
+int AISystem::select_target(vec2 center, float range, TARGET_POLICY policy) const
+{
+	const float range_sq = range * range;
+	auto in_range = [&](int i) {
+		vec2 d = invader_positions[i] - center;
+		return dot(d, d) <= range_sq;
+	};
+
+	int best = -1;
+	switch (policy) {
+	case TARGET_POLICY::FIRST:
+	case TARGET_POLICY::LAST:
+		// cells are sorted by progress, so the first invader in range from the matching
+		// end of each cell is that cell's answer
+		invader_grid.for_each_cell(center, range, [&](const int* first, const int* last) {
+			if (policy == TARGET_POLICY::FIRST) {
+				for (const int* it = first; it != last; ++it) {
+					if (!in_range(*it))
+						continue;
+					if (best < 0 || invader_progress[*it] > invader_progress[best])
+						best = *it;
+					break;
+				}
+			}
+			else {
+				for (const int* it = last; it != first; --it) {
+					if (!in_range(*(it - 1)))
+						continue;
+					if (best < 0 || invader_progress[*(it - 1)] < invader_progress[best])
+						best = *(it - 1);
+					break;
+				}
+			}
+		});
+		break;
+
+	case TARGET_POLICY::STRONGEST:
+	case TARGET_POLICY::WEAKEST:
+		// ties go to the invader further along
+		invader_grid.query(center, range, [&](int i) {
+			if (!in_range(i))
+				return true;
+			if (best < 0) {
+				best = i;
+				return true;
+			}
+			int health_diff = invader_health[i] - invader_health[best];
+			if (policy == TARGET_POLICY::WEAKEST)
+				health_diff = -health_diff;
+			if (health_diff > 0 || (health_diff == 0 && invader_progress[i] > invader_progress[best]))
+				best = i;
+			return true;
+		});
+		break;
+
+	default: {
+		// closest, comparing squared distances
+		float best_sq = range_sq;
+		invader_grid.query(center, range, [&](int i) {
+			vec2 d = invader_positions[i] - center;
+			float dist_sq = dot(d, d);
+			if (dist_sq <= best_sq && (best < 0 || dist_sq < best_sq)) {
+				best_sq = dist_sq;
+				best = i;
+			}
+			return true;
+		});
+		break;
+	}
+	}
+	return best;
+}
+
+// Bucket the invaders for target queries and compute their path progress
+void AISystem::prepare_targeting()
+{
+	const size_t num_invaders = registry.invaders.entities.size();
+	invader_positions.resize(num_invaders);
+	invader_progress.resize(num_invaders);
+	invader_health.resize(num_invaders);
+	for (size_t i = 0; i < num_invaders; i++) {
+		Entity invader = registry.invaders.entities[i];
+		const vec2 position = registry.motions.get(invader).position;
+		invader_positions[i] = position;
+		invader_health[i] = registry.invaders.components[i].health;
+
+		// path left = steps from the cursor cell to the exit plus the way to that cell
+		float progress = -INFINITY;
+		if (registry.flowCursors.has(invader)) {
+			ivec2 cell = registry.flowCursors.get(invader).cell;
+			int steps = flow_field.distance(cell);
+			if (steps != FlowField::UNREACHABLE) {
+				vec2 center = vec2(
+					cell.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f,
+					cell.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f
+				);
+				progress = -(steps * (float)GRID_CELL_WIDTH_PX + glm::distance(position, center));
+			}
+		}
+		invader_progress[i] = progress;
+	}
+	invader_grid.build(invader_positions, TARGETING_GRID_CELL_PX);
+	for (int c : invader_grid.occupied) {
+		std::sort(invader_grid.items.begin() + invader_grid.cell_start[c], invader_grid.items.begin() + invader_grid.cell_start[c + 1],
+			[&](int a, int b) { return invader_progress[a] > invader_progress[b]; });
+	}
+}
 
 void AISystem::step(float elapsed_ms)
 {
@@ -10,70 +361,206 @@ void AISystem::step(float elapsed_ms)
 	// !!! TODO A1: scan for invaders and shoot at them
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	// invader detection system for towers
-	// - for each tower, scan its row:
-	//   - if an invader is detected and the tower's shooting timer has expired,
+	// - for each tower, pick an invader in range by the tower's targeting policy:
+	//   - turn toward it, and if the tower's shooting timer has expired,
 	//     then shoot (create a projectile) and reset the tower's shot timer
-	for (const Entity& tower_entity : registry.towers.entities) {
-        Motion& tower_motion = registry.motions.get(tower_entity);
-        Tower& tower = registry.towers.get(tower_entity);
+	// the targeting grid is only built on frames where some tower re-acquires
 
-        tower.timer_ms -= elapsed_ms;
+	// towers with no invader in the cells they cover do no work at all
+	coverage_map.update();
 
-        if (!registry.invaders.entities.empty()) {
-            Entity closest_invader = registry.invaders.entities[0];
-            float minDistance = glm::distance(tower_motion.position,
-                registry.motions.get(closest_invader).position);
-            for (size_t i = 1; i < registry.invaders.entities.size(); i++) {
-                Entity candidate = registry.invaders.entities[i];
-                float candidateDistance = glm::distance(tower_motion.position, registry.motions.get(candidate).position);
-                if (candidateDistance < minDistance) {
-                    minDistance = candidateDistance;
-                    closest_invader = candidate;
-                }
-            }
+	const size_t num_towers = registry.towers.entities.size();
+	tower_positions.resize(num_towers);
+	tower_angles.resize(num_towers);
+	tower_ranges.resize(num_towers);
+	tower_policies.resize(num_towers);
+	tower_shot_speeds.resize(num_towers);
+	target_positions.resize(num_towers);
+	target_forecasts.resize(num_towers);
+	acquired.resize(num_towers);
+	aim_angle.resize(num_towers);
+	aim_dir.resize(num_towers);
+	aim_has_intercept.resize(num_towers);
+	aim_intercept.resize(num_towers);
+	aim_intercept_time.resize(num_towers);
+	forecast_index.clear();
+	forecasts.clear();
+	forecast_points.clear();
+	forecast_times.clear();
+	const float max_turn = TOWER_TURN_SPEED * (elapsed_ms / 1000.f);
 
-            Motion& invader_motion = registry.motions.get(closest_invader);
+	// The step runs in phases so the per-tower work can be spread over the workers:
+	// a serial gather out of the registry, parallel target acquisition, a serial pass
+	// that builds the forecasts of the chosen targets, parallel leading and aiming, and a
+	// serial commit, firing type by type in tower order. Parallel jobs only write their
+	// towers' result slots, so the outcome does not depend on how the towers are split.
 
-            float desiredAngle = -glm::degrees(atan2(invader_motion.position.y - tower_motion.position.y, invader_motion.position.x - tower_motion.position.x));
-            float currentAngle = tower_motion.angle;
-            float deltaAngle = desiredAngle - currentAngle;
-            while (deltaAngle > 180.f) {
-                deltaAngle -= 360.f;
-            }
-            while (deltaAngle < -180.f) {
-                deltaAngle += 360.f;
-            }
+	// gather: keep or drop current targets, queue the towers due a re-acquisition
+	active.clear();
+	acquiring.clear();
+	for (int t = 0; t < (int)num_towers; t++) {
+        Tower& tower = registry.towers.components[t];
+        tower.timer_ms -= elapsed_ms;
+        if (!coverage_map.occupied(t)) {
+            tower.has_target = false;
+            continue;
+        }
+        tower.retarget_ms -= elapsed_ms;
 
-            
-            float turnSpeed = 175.f;  
-            float maxTurn = turnSpeed * (elapsed_ms / 1000.f);
+        // something just came into view: look for it now instead of at the next staggered slot
+        if (coverage_map.take_wake(t) && !tower.has_target)
+            tower.retarget_ms = min(tower.retarget_ms, 0.f);
 
-            if (fabs(deltaAngle) < maxTurn) {
-                tower_motion.angle = desiredAngle;
-            }
-            else {
-                tower_motion.angle += (deltaAngle > 0 ? maxTurn : -maxTurn);
+        const Motion& tower_motion = registry.motions.get(registry.towers.entities[t]);
+        tower_positions[t] = tower_motion.position;
+        tower_angles[t] = tower_motion.angle;
+        tower_ranges[t] = tower.range;
+        tower_policies[t] = tower.targeting;
+        tower_shot_speeds[t] = TOWER_ARCHETYPES.projectile_speed[(int)tower.type];
+
+        // between re-acquisitions only check that the current target is still alive and in range
+        bool lost_target = false;
+        if (tower.has_target) {
+            tower.has_target = registry.invaders.has(tower.target);
+            if (tower.has_target) {
+                target_positions[t] = registry.motions.get(tower.target).position;
+                const vec2 d = target_positions[t] - tower_positions[t];
+                tower.has_target = dot(d, d) <= tower.range * tower.range;
             }
+            lost_target = !tower.has_target;
         }
 
-       
-        const float rowTolerance = 5.0f; 
-
-        if (tower.timer_ms <= 0) {
-            float range_pixels = tower.range;
-            for (const Entity& invader_entity : registry.invaders.entities) {
-                Motion& invader_motion = registry.motions.get(invader_entity);
-                float distance = glm::distance(tower_motion.position, invader_motion.position);
-                if (distance <= range_pixels) {
-                    vec2 projectile_position = tower_motion.position;
-                    float speed = 1000.f;
-                    float angleRad = glm::radians(-tower_motion.angle);
-                    vec2 projectile_velocity = { cos(angleRad) * speed, sin(angleRad) * speed };
-                    createProjectile(projectile_position, vec2(20.f, 20.f), projectile_velocity);
-                    tower.timer_ms = TOWER_TIMER_MS; 
-                    break;
-                }
-            }
+        // re-acquire at TOWER_RETARGET_MS intervals, staggered per tower, or right after losing the target
+        if (tower.retarget_ms <= 0.f || lost_target) {
+            acquiring.push_back(t);
+            if (tower.retarget_ms <= 0.f)
+                tower.retarget_ms += TOWER_RETARGET_MS;
+        }
+        active.push_back(t);
+	}
+
+	// acquire: grid queries in parallel, each tower writing its own slot
+	if (!acquiring.empty()) {
+		prepare_targeting();
+		workers->parallel_for(acquiring.size(), AI_PARALLEL_MIN_TOWERS, [&](size_t, size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const int t = acquiring[i];
+				acquired[t] = select_target(tower_positions[t], tower_ranges[t], tower_policies[t]);
+			}
+		});
+	}
+
+	// apply the acquisitions in tower order and forecast every target once
+	for (int t : acquiring) {
+        Tower& tower = registry.towers.components[t];
+        tower.has_target = acquired[t] >= 0;
+        if (tower.has_target) {
+            tower.target = registry.invaders.entities[acquired[t]];
+            target_positions[t] = invader_positions[acquired[t]];
         }
 	}
-}
\ No newline at end of file
+	aiming.clear();
+	for (int t : active) {
+        const Tower& tower = registry.towers.components[t];
+        if (!tower.has_target)
+            continue;
+        target_forecasts[t] = forecast(tower.target);
+        aiming.push_back(t);
+	}
+
+	// aim: intercepts and the aim kernel in parallel
+	workers->parallel_for(aiming.size(), AI_PARALLEL_MIN_TOWERS, [&](size_t, size_t begin, size_t end) {
+		aim(begin, end, max_turn);
+	});
+#ifdef AI_CHECK_PARALLEL
+	check_parallel(max_turn);
+#endif
+
+	// commit: turn, then fire the towers that are ready, grouped by type
+	for (std::vector<int>& group : firing)
+		group.clear();
+	for (int t : aiming) {
+        const Tower& tower = registry.towers.components[t];
+        registry.motions.get(registry.towers.entities[t]).angle = aim_angle[t];
+        if (tower.timer_ms <= 0)
+            firing[(int)tower.type].push_back(t);
+	}
+	fire_groups(std::make_index_sequence<(size_t)TOWER_TYPE::TYPE_COUNT>{});
+}
+
+#ifdef AI_CHECK_PARALLEL
+// Redo this step's acquisitions and aiming on one worker and compare with what the parallel
+// phases produced, which has to match bit for bit. Doubles the AI cost, so it is only built
+// with the AI_CHECK_PARALLEL option.
+void AISystem::check_parallel(float max_turn)
+{
+	size_t mismatches = 0;
+	for (int t : acquiring) {
+		if (acquired[t] != select_target(tower_positions[t], tower_ranges[t], tower_policies[t]))
+			mismatches++;
+	}
+
+	const std::vector<float> parallel_angle = aim_angle;
+	const std::vector<vec2> parallel_dir = aim_dir;
+	const std::vector<uint8_t> parallel_has_intercept = aim_has_intercept;
+	const std::vector<vec2> parallel_intercept = aim_intercept;
+	const std::vector<float> parallel_intercept_time = aim_intercept_time;
+	aim(0, aiming.size(), max_turn);
+	for (int t : aiming) {
+		if (memcmp(&parallel_angle[t], &aim_angle[t], sizeof(float)) != 0
+			|| memcmp(&parallel_dir[t], &aim_dir[t], sizeof(vec2)) != 0
+			|| parallel_has_intercept[t] != aim_has_intercept[t]
+			|| (aim_has_intercept[t] && (memcmp(&parallel_intercept[t], &aim_intercept[t], sizeof(vec2)) != 0
+				|| memcmp(&parallel_intercept_time[t], &aim_intercept_time[t], sizeof(float)) != 0)))
+			mismatches++;
+	}
+
+	if (mismatches > 0)
+		std::cerr << "ERROR: parallel AI step differs from a single worker for " << mismatches << " towers" << std::endl;
+	assert(mismatches == 0);
+}
+#endif
+
+template <size_t... types>
+void AISystem::fire_groups(std::index_sequence<types...>)
+{
+	(fire<(TOWER_TYPE)types>(firing[types]), ...);
+}
+
+// Fire the given towers of one type at their targets. Everything that depends on the type
+// is a compile-time constant here, the only per-tower choice left is the fire mode.
+template <TOWER_TYPE type>
+void AISystem::fire(const std::vector<int>& tower_indices)
+{
+	using Behaviour = TowerFire<type>;
+	const float speed = TOWER_ARCHETYPES.projectile_speed[(int)type];
+	const int damage = TOWER_ARCHETYPES.damage[(int)type];
+	const int fire_ms = TOWER_ARCHETYPES.fire_ms[(int)type];
+
+	// rotation of the aim direction for each shot of the fan
+	vec2 fan[Behaviour::SHOTS];
+	for (int s = 0; s < Behaviour::SHOTS; s++) {
+		const float offset = glm::radians(Behaviour::SPREAD_DEG * (s - (Behaviour::SHOTS - 1) / 2.f));
+		fan[s] = { cos(offset), sin(offset) };
+	}
+
+	for (int t : tower_indices) {
+		Tower& tower = registry.towers.components[t];
+		if (tower.fire_mode == FIRE_MODE::HIT_SCAN) {
+			// no projectile: the damage is scheduled for when one would have arrived
+			if (!aim_has_intercept[t])
+				continue;
+			registry.pending_hits.push_back({ tower.target, aim_intercept_time[t] * 1000.f, damage });
+			if (tower.tracer)
+				createTracer(tower_positions[t], aim_intercept[t]);
+		}
+		else {
+			const vec2 dir = aim_dir[t];
+			for (int s = 0; s < Behaviour::SHOTS; s++) {
+				const vec2 shot = { dir.x * fan[s].x - dir.y * fan[s].y, dir.x * fan[s].y + dir.y * fan[s].x };
+				createProjectile(tower_positions[t], vec2(20.f, 20.f), shot * speed, damage);
+			}
+		}
+		tower.timer_ms = fire_ms;
+	}
+}
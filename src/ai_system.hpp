@@ -3,9 +3,93 @@
 #include "common.hpp"
 #include "render_system.hpp"
 #include "tinyECS/registry.hpp"
+#include "spatial_grid.hpp"
+#include "worker_pool.hpp"
+
+#include <array>
+#include <unordered_map>
+#include <utility>
+
+// An invader's predicted route: the points it walks through along its flow-field path
+// and when it gets to each, the first one being where it is now
+struct PathForecast
+{
+	int first = 0;	// points and times are [first, first + count) of the AISystem forecast arrays
+	int count = 0;
+	bool open_ended = false;	// off the field: keeps moving at tail_velocity after the last point
+	vec2 tail_velocity = { 0, 0 };
+};
 
 class AISystem
 {
 public:
+	// the pool is shared with the physics system, the two never run at the same time
+	void init(WorkerPool* pool) { workers = pool; }
 	void step(float elapsed_ms);
+
+private:
+	// fills the grid and per-invader arrays below, at most once per step
+	void prepare_targeting();
+
+	// lead and aim the towers in aiming[begin, end), filling their aim_* slots
+	void aim(size_t begin, size_t end, float max_turn);
+
+#ifdef AI_CHECK_PARALLEL
+	// compare this step's parallel results with a single-worker run
+	void check_parallel(float max_turn);
+#endif
+
+	// fire each type's group of ready towers with that type's fire<> instance
+	template <size_t... types>
+	void fire_groups(std::index_sequence<types...>);
+	template <TOWER_TYPE type>
+	void fire(const std::vector<int>& tower_indices);
+
+	// index into forecasts of the invader's route, built on first use in a step and
+	// shared by all towers aiming at it
+	int forecast(Entity invader);
+
+	// time and place a shot at shot_speed from shooter meets the invader on its forecast route,
+	// false if the invader leaves first
+	bool solve_intercept(vec2 shooter, float shot_speed, const PathForecast& f, vec2& hit_point, float& hit_time) const;
+
+	// index into registry.invaders of the invader the policy picks among those within range, -1 if none
+	int select_target(vec2 center, float range, TARGET_POLICY policy) const;
+
+	// invaders bucketed once per step and shared by every tower's query;
+	// each grid cell lists its invaders by decreasing progress
+	SpatialGrid invader_grid;
+	std::vector<vec2> invader_positions;
+	std::vector<float> invader_progress;	// minus the path length left to the exit, larger is further along
+	std::vector<int> invader_health;
+
+	WorkerPool* workers = nullptr;
+
+	// per-tower inputs gathered from the registry and result slots of the parallel
+	// phases, indexed like registry.towers
+	std::vector<vec2> tower_positions;
+	std::vector<float> tower_angles;
+	std::vector<float> tower_ranges;
+	std::vector<TARGET_POLICY> tower_policies;
+	std::vector<float> tower_shot_speeds;
+	std::vector<vec2> target_positions;
+	std::vector<int> target_forecasts;
+	std::vector<int> acquired;	// select_target result of the towers re-acquiring
+	std::vector<float> aim_angle;
+	std::vector<vec2> aim_dir;	// unit shot direction at the new angle
+	std::vector<uint8_t> aim_has_intercept;
+	std::vector<vec2> aim_intercept;		// where a shot fired this step meets the target
+	std::vector<float> aim_intercept_time;	// in seconds
+
+	// towers taking part in this step, re-acquiring and with a target, in tower order
+	std::vector<int> active;
+	std::vector<int> acquiring;
+	std::vector<int> aiming;
+	std::array<std::vector<int>, (size_t)TOWER_TYPE::TYPE_COUNT> firing;	// ready to fire, by type
+
+	// per-step invader forecasts, keyed by entity id
+	std::unordered_map<unsigned int, int> forecast_index;
+	std::vector<PathForecast> forecasts;
+	std::vector<vec2> forecast_points;
+	std::vector<float> forecast_times;	// seconds from now
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "common.hpp"
 
+MapGrid map_grid;
+
 // Note, we could also use the functions from GLM but we write the transformations here to show the uderlying math
 void Transform::scale(vec2 scale)
 {
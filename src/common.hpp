@@ -40,9 +40,17 @@ inline std::string level_path(const std::string& name) { return data_path() + "/
 // const int WINDOW_HEIGHT_PX = 600;
 
 // A2: number of grid cells increased from 14x10 (A1) to 21x12 (A2)
+// this is the window (the viewport onto the map) and the size of a level that does not set one
 const int NUM_GRID_CELLS_WIDE = 21;
 const int NUM_GRID_CELLS_HIGH = 12;
 
+// largest map side a level file may ask for, in cells
+const int MAX_GRID_CELLS = 4096;
+
+// path searches on maps of more cells than this run over square clusters of this many cells a side
+const int PATH_HIERARCHY_MIN_CELLS = 64 * 64;
+const int PATH_CLUSTER_CELLS = 16;
+
 const int GRID_CELL_WIDTH_PX = 60;
 const int GRID_CELL_HEIGHT_PX = 60;
 const int GRID_LINE_WIDTH_PX = 2;
@@ -50,9 +58,16 @@ const int GRID_LINE_WIDTH_PX = 2;
 const int WINDOW_WIDTH_PX = NUM_GRID_CELLS_WIDE * GRID_CELL_WIDTH_PX;
 const int WINDOW_HEIGHT_PX = NUM_GRID_CELLS_HIGH * GRID_CELL_HEIGHT_PX;
 
-const int TOWER_TIMER_MS = 1000;	// number of milliseconds between tower shots
+const int TOWER_TIMER_MS = 1000;	// number of milliseconds between shots of the basic tower
+
+// towers re-acquire targets at 10 Hz, first re-acquisitions are spread over this many slots
+const float TOWER_RETARGET_MS = 100.f;
+const int TOWER_RETARGET_SLOTS = 8;
 const int MAX_TOWERS_START = 5;
 
+// how fast towers turn toward their target, in degrees/s
+const float TOWER_TURN_SPEED = 175.f;
+
 const int INVADER_BLUE_HEALTH = 70;
 const int INVADER_RED_HEALTH = 60;
 const int INVADER_GREEN_HEALTH = 80;
@@ -61,8 +76,23 @@ const int INVADER_SPAWN_RATE_MS = 2 * 1000;
 // A2: speed of the blue invader on the playing screen
 const int BLUE_INVADER_SPEED = 80;
 
+// walking speed of all invaders along the flow field, in px/s
+const float INVADER_SPEED = 100.f;
+
 const int PROJECTILE_DAMAGE = 10;
 
+// muzzle speed of the basic tower's shots in px/s, hit-scan towers solve their time of impact with their type's speed
+const float PROJECTILE_SPEED = 1000.f;
+
+// cell size of the grid towers search for targets in, a tower's range spans a few cells
+const float TARGETING_GRID_CELL_PX = 2.f * GRID_CELL_WIDTH_PX;
+
+// how long a hit-scan tracer stays on screen
+const float TRACER_LIFETIME_MS = 80.f;
+
+// capacity of the projectile pool, shots beyond it are dropped
+const int MAX_PROJECTILES = 512;
+
 // These are hard coded to the dimensions of the entity's texture
 
 // invaders are 64x64 px, but cells are 60x60
@@ -77,6 +107,35 @@ const float TOWER_BB_HEIGHT = (float)GRID_CELL_HEIGHT_PX;
 const float TILE_BB_WIDTH = (float)GRID_CELL_WIDTH_PX;
 const float TILE_BB_HEIGHT = (float)GRID_CELL_HEIGHT_PX;
 
+// collider boxes cover the opaque body of the sprites as drawn, well inside a cell,
+// so an invader on its lane does not touch a tower standing on the next cell
+const float INVADER_BODY_WIDTH = 36.f;
+const float INVADER_BODY_HEIGHT = 40.f;
+const float TOWER_BODY_WIDTH = 40.f;
+const float TOWER_BODY_HEIGHT = 36.f;
+
+// crowd steering: invaders closer than the radius push apart, each looks at a bounded number of neighbours
+const float CROWD_SEPARATION_RADIUS = INVADER_BB_WIDTH / 2.f;
+const float CROWD_SEPARATION_WEIGHT = 0.75f;
+const int CROWD_MAX_NEIGHBOURS = 6;
+
+// invaders stay within this distance of the center lines of their path tile's lanes, so the
+// crowd can spread them sideways but never push a body (INVADER_BODY_*) onto the next cell
+const float INVADER_LANE_HALF_WIDTH = GRID_CELL_WIDTH_PX / 5.f;
+
+// per-frame spatial grids (crowd, targeting, collision) get at most this many cells per point, plus a minimum
+const size_t SPATIAL_GRID_CELLS_PER_POINT = 4;
+const size_t SPATIAL_GRID_MIN_CELLS = 256;
+
+// below this many bodies the collision narrowphase stays on the main thread
+const size_t NARROWPHASE_PARALLEL_MIN_BODIES = 256;
+
+// towers each worker takes at least in the parallel AI phases, fewer run on the main thread
+const size_t AI_PARALLEL_MIN_TOWERS = 64;
+
+// contacts reserved per frame up front, the buffer still grows past this if needed
+const size_t MAX_CONTACTS = 1024;
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
@@ -92,3 +151,19 @@ struct Transform {
 };
 
 bool gl_has_errors();
+
+// A2: the grid of the current level, in cells. A level file sets it with a "size W H"
+// line and may be much larger than the window; everything indexed by grid cell (tiles,
+// flow field, path searches, collision and coverage layers) is sized from it.
+struct MapGrid {
+	int wide = NUM_GRID_CELLS_WIDE;
+	int high = NUM_GRID_CELLS_HIGH;
+
+	int count() const { return wide * high; }
+	bool in_bounds(ivec2 cell) const { return cell.x >= 0 && cell.x < wide && cell.y >= 0 && cell.y < high; }
+	int index(ivec2 cell) const { return cell.y * wide + cell.x; }
+	ivec2 cell_of(int i) const { return { i % wide, i / wide }; }
+	vec2 size_px() const { return vec2(wide * GRID_CELL_WIDTH_PX, high * GRID_CELL_HEIGHT_PX); }
+};
+
+extern MapGrid map_grid;
@@ -0,0 +1,119 @@
+// internal
+#include "coverage_map.hpp"
+#include "tinyECS/registry.hpp"
+
+CoverageMap coverage_map;
+
+void CoverageMap::build()
+{
+	const int num_cells = map_grid.count();
+	const size_t num_towers = registry.towers.entities.size();
+
+	// a cell is covered if any part of it lies within range (closest point of the cell to the tower)
+	auto covers = [](vec2 center, float range, int cx, int cy) {
+		vec2 lo = vec2(cx * GRID_CELL_WIDTH_PX, cy * GRID_CELL_HEIGHT_PX);
+		vec2 hi = lo + vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX);
+		vec2 d = clamp(center, lo, hi) - center;
+		return dot(d, d) <= range * range;
+	};
+	auto for_each_covered = [&](size_t t, auto&& visit) {
+		const vec2 center = registry.motions.get(registry.towers.entities[t]).position;
+		const float range = registry.towers.components[t].range;
+		const int x0 = max((int)floor((center.x - range) / GRID_CELL_WIDTH_PX), 0);
+		const int y0 = max((int)floor((center.y - range) / GRID_CELL_HEIGHT_PX), 0);
+		const int x1 = min((int)floor((center.x + range) / GRID_CELL_WIDTH_PX), map_grid.wide - 1);
+		const int y1 = min((int)floor((center.y + range) / GRID_CELL_HEIGHT_PX), map_grid.high - 1);
+		for (int cy = y0; cy <= y1; cy++) {
+			for (int cx = x0; cx <= x1; cx++) {
+				if (covers(center, range, cx, cy))
+					visit(cy * map_grid.wide + cx);
+			}
+		}
+	};
+
+	// count, prefix sum, fill
+	cell_start.assign(num_cells + 1, 0);
+	for (size_t t = 0; t < num_towers; t++)
+		for_each_covered(t, [&](int cell) { cell_start[cell + 1]++; });
+	for (int c = 0; c < num_cells; c++)
+		cell_start[c + 1] += cell_start[c];
+
+	towers.resize(cell_start[num_cells]);
+	std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+	for (size_t t = 0; t < num_towers; t++)
+		for_each_covered(t, [&](int cell) { towers[fill[cell]++] = (int)t; });
+
+	// tower indices changed, so recount from where the followed invaders are
+	occupancy.assign(num_towers, 0);
+	woken.assign(num_towers, 0);
+	built = true;
+	for (int cell : tracked_cells)
+		enter(cell);
+}
+
+void CoverageMap::update()
+{
+	if (!built)
+		build();
+
+	// invaders that died or left since the last update drop out, the others move cells
+	for (size_t k = 0; k < tracked.size();) {
+		if (!registry.invaders.has(tracked[k])) {
+			leave(tracked_cells[k]);
+			tracked[k] = tracked.back();
+			tracked_cells[k] = tracked_cells.back();
+			tracked.pop_back();
+			tracked_cells.pop_back();
+			continue;
+		}
+		int cell = cell_of(registry.motions.get(tracked[k]).position);
+		if (cell != tracked_cells[k]) {
+			leave(tracked_cells[k]);
+			enter(cell);
+			tracked_cells[k] = cell;
+		}
+		k++;
+	}
+
+	// start following new invaders
+	for (size_t i = 0; i < registry.invaders.components.size(); i++) {
+		Invader& invader = registry.invaders.components[i];
+		if (invader.coverage_tracked)
+			continue;
+		invader.coverage_tracked = true;
+		Entity entity = registry.invaders.entities[i];
+		int cell = cell_of(registry.motions.get(entity).position);
+		tracked.push_back(entity);
+		tracked_cells.push_back(cell);
+		enter(cell);
+	}
+}
+
+bool CoverageMap::take_wake(int tower)
+{
+	bool was_woken = woken[tower];
+	woken[tower] = 0;
+	return was_woken;
+}
+
+int CoverageMap::cell_of(vec2 position) const
+{
+	// off-grid invaders count toward the nearest edge cell, which is no further from any tower
+	int cx = clamp((int)floor(position.x / GRID_CELL_WIDTH_PX), 0, map_grid.wide - 1);
+	int cy = clamp((int)floor(position.y / GRID_CELL_HEIGHT_PX), 0, map_grid.high - 1);
+	return cy * map_grid.wide + cx;
+}
+
+void CoverageMap::enter(int cell)
+{
+	for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++) {
+		if (occupancy[towers[k]]++ == 0)
+			woken[towers[k]] = 1;
+	}
+}
+
+void CoverageMap::leave(int cell)
+{
+	for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++)
+		occupancy[towers[k]]--;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+#include <vector>
+
+// Which towers can see which grid cells, so towers only do targeting work while an
+// invader is somewhere in their range.
+// For every tile cell the map lists the towers whose range touches it (flat, per-cell
+// ranges into one array), rebuilt only after a tower is placed or removed. Invaders are
+// followed cell by cell: crossing into a new cell bumps the occupancy of the towers
+// covering it and drops that of the towers covering the old one, so a tower with zero
+// occupancy has nothing in range and the AI system skips it outright.
+class CoverageMap
+{
+public:
+	// bucket every tower's range into the cells it covers and recount occupancy
+	void build();
+
+	// mark the map stale after a tower change, rebuilt on the next update()
+	void invalidate() { built = false; }
+	bool ready() const { return built; }
+
+	// follow the invaders into their current cells, rebuilding first if stale
+	void update();
+
+	// towers are indexed like registry.towers as of the last build
+	bool occupied(int tower) const { return occupancy[tower] > 0; }
+
+	// true once after the tower's occupancy rose from zero, i.e. something just came into view
+	bool take_wake(int tower);
+
+private:
+	int cell_of(vec2 position) const;
+	void enter(int cell);
+	void leave(int cell);
+
+	bool built = false;
+
+	std::vector<int> cell_start;	// towers covering cell c are towers[cell_start[c] .. cell_start[c + 1])
+	std::vector<int> towers;
+	std::vector<int> occupancy;		// invaders currently in cells the tower covers
+	std::vector<uint8_t> woken;
+
+	// invaders being followed and the cell they were last seen in
+	std::vector<Entity> tracked;
+	std::vector<int> tracked_cells;
+};
+
+extern CoverageMap coverage_map;
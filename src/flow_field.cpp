@@ -0,0 +1,302 @@
+// internal
+#include "flow_field.hpp"
+#include "tiles.hpp"
+#include "tinyECS/registry.hpp"
+
+#include <algorithm>
+#include <functional>
+
+FlowField flow_field;
+
+// offsets for top (0), right (1), bottom (2), left (3)
+static const ivec2 DIRECTIONS[4] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+
+static uint8_t opposite(uint8_t d) { return (d + 2) % 4; }
+
+void FlowField::build()
+{
+	const int num_cells = map_grid.count();
+	dist.assign(num_cells, UNREACHABLE);
+	dir.assign(num_cells, DIR_NONE);
+	open.assign(num_cells, 0);
+	exits.assign(num_cells, 0);
+	starts.assign(num_cells, 0);
+	blocked.assign(num_cells, 0);
+
+	// flatten the level tiles into the grid (tile-selector tiles are not part of the level)
+	for (uint i = 0; i < registry.tiles.components.size(); i++) {
+		if (registry.selectables.has(registry.tiles.entities[i]))
+			continue;
+
+		const Tile& tile = registry.tiles.components[i];
+		ivec2 cell = { tile.tx, tile.ty };
+		if (!in_bounds(cell))
+			continue;
+
+		open[index(cell)] = tile_sides(tile.tile_id);
+		exits[index(cell)] = is_exit_tile(tile.tile_id);
+		starts[index(cell)] = is_start_tile(tile.tile_id);
+	}
+
+	// towers standing on path tiles (mazing) wall their cell off
+	for (Entity tower : registry.towers.entities) {
+		const Motion& motion = registry.motions.get(tower);
+		ivec2 cell = ivec2(motion.position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX));
+		if (in_bounds(cell))
+			blocked[index(cell)] = 1;
+	}
+
+	// reverse BFS from all exits at once; every edge costs one step
+	std::vector<int> queue;
+	queue.reserve(num_cells);
+	for (int i = 0; i < num_cells; i++) {
+		if (exits[i] && !blocked[i]) {
+			dist[i] = 0;
+			queue.push_back(i);
+		}
+	}
+
+	for (size_t head = 0; head < queue.size(); head++) {
+		int current = queue[head];
+		for (uint8_t d = 0; d < 4; d++) {
+			int neighbor = step(current, d);
+			if (neighbor < 0 || dist[neighbor] != UNREACHABLE)
+				continue;
+
+			dist[neighbor] = dist[current] + 1;
+			dir[neighbor] = opposite(d);
+			queue.push_back(neighbor);
+		}
+	}
+
+	built = true;
+	revision_count++;
+}
+
+bool FlowField::block(ivec2 cell)
+{
+	if (!built)
+		build();
+	if (!in_bounds(cell))
+		return true;
+
+	const int blocked_cell = index(cell);
+	if (blocked[blocked_cell])
+		return true;
+	blocked[blocked_cell] = 1;
+
+	// nothing routes through a cell that cannot reach an exit
+	if (dist[blocked_cell] == UNREACHABLE)
+		return true;
+
+	// the cells whose route runs through the blocked one are exactly its subtree
+	// in the direction tree, every other distance stays valid
+	affected.clear();
+	affected.push_back(blocked_cell);
+	for (size_t head = 0; head < affected.size(); head++) {
+		ivec2 parent = cell_of(affected[head]);
+		for (uint8_t d = 0; d < 4; d++) {
+			ivec2 child = parent + DIRECTIONS[d];
+			if (in_bounds(child) && dir[index(child)] == opposite(d))
+				affected.push_back(index(child));
+		}
+	}
+
+	saved.clear();
+	for (int i : affected) {
+		saved.push_back({ dist[i], dir[i] });
+		dist[i] = UNREACHABLE;
+		dir[i] = DIR_NONE;
+	}
+
+	// seed each affected cell from its best neighbour outside the region, then settle
+	// the region with Dijkstra (seeds differ in distance, so a plain FIFO is not enough)
+	frontier.clear();
+	for (int i : affected) {
+		if (i == blocked_cell)
+			continue;
+		for (uint8_t d = 0; d < 4; d++) {
+			int neighbor = step(i, d);
+			if (neighbor < 0 || dist[neighbor] == UNREACHABLE)
+				continue;
+			if (dist[i] == UNREACHABLE || dist[neighbor] + 1 < dist[i]) {
+				dist[i] = dist[neighbor] + 1;
+				dir[i] = d;
+			}
+		}
+		if (dist[i] != UNREACHABLE) {
+			frontier.push_back({ dist[i], i });
+			std::push_heap(frontier.begin(), frontier.end(), std::greater<>());
+		}
+	}
+
+	while (!frontier.empty()) {
+		std::pop_heap(frontier.begin(), frontier.end(), std::greater<>());
+		auto [current_dist, current] = frontier.back();
+		frontier.pop_back();
+		if (current_dist > dist[current])
+			continue;
+
+		for (uint8_t d = 0; d < 4; d++) {
+			int neighbor = step(current, d);
+			if (neighbor < 0)
+				continue;
+			if (dist[neighbor] == UNREACHABLE || current_dist + 1 < dist[neighbor]) {
+				dist[neighbor] = current_dist + 1;
+				dir[neighbor] = opposite(d);
+				frontier.push_back({ dist[neighbor], neighbor });
+				std::push_heap(frontier.begin(), frontier.end(), std::greater<>());
+			}
+		}
+	}
+
+	// reject the edit if a start tile lost its last route, only affected cells can have
+	for (int i : affected) {
+		if (starts[i] && dist[i] == UNREACHABLE) {
+			for (size_t k = 0; k < affected.size(); k++) {
+				dist[affected[k]] = saved[k].first;
+				dir[affected[k]] = saved[k].second;
+			}
+			blocked[blocked_cell] = 0;
+			return false;
+		}
+	}
+	revision_count++;
+	return true;
+}
+
+void FlowField::unblock(ivec2 cell)
+{
+	if (!built || !in_bounds(cell))
+		return;
+
+	const int freed_cell = index(cell);
+	if (!blocked[freed_cell])
+		return;
+	blocked[freed_cell] = 0;
+
+	if (exits[freed_cell]) {
+		dist[freed_cell] = 0;
+		dir[freed_cell] = DIR_NONE;
+	}
+	else {
+		for (uint8_t d = 0; d < 4; d++) {
+			int neighbor = step(freed_cell, d);
+			if (neighbor < 0 || dist[neighbor] == UNREACHABLE)
+				continue;
+			if (dist[freed_cell] == UNREACHABLE || dist[neighbor] + 1 < dist[freed_cell]) {
+				dist[freed_cell] = dist[neighbor] + 1;
+				dir[freed_cell] = d;
+			}
+		}
+		if (dist[freed_cell] == UNREACHABLE)
+			return;
+	}
+
+	// every improvement flows out of the freed cell, so a FIFO visits them in distance order
+	// and stops where distances no longer shrink
+	affected.clear();
+	affected.push_back(freed_cell);
+	for (size_t head = 0; head < affected.size(); head++) {
+		int current = affected[head];
+		for (uint8_t d = 0; d < 4; d++) {
+			int neighbor = step(current, d);
+			if (neighbor < 0)
+				continue;
+			if (dist[neighbor] == UNREACHABLE || dist[current] + 1 < dist[neighbor]) {
+				dist[neighbor] = dist[current] + 1;
+				dir[neighbor] = opposite(d);
+				affected.push_back(neighbor);
+			}
+		}
+	}
+	revision_count++;
+}
+
+int FlowField::step(int from, uint8_t d) const
+{
+	ivec2 to_cell = cell_of(from) + DIRECTIONS[d];
+	if (!in_bounds(to_cell))
+		return -1;
+
+	int to = index(to_cell);
+	if (blocked[from] || blocked[to])
+		return -1;
+
+	// both tiles must open toward each other, same rule as PathSearch
+	if (!(open[from] & (1 << d)) || !(open[to] & (1 << opposite(d))))
+		return -1;
+	return to;
+}
+
+bool FlowField::in_bounds(ivec2 cell) const
+{
+	return map_grid.in_bounds(cell);
+}
+
+bool FlowField::is_exit(ivec2 cell) const
+{
+	return built && in_bounds(cell) && exits[index(cell)];
+}
+
+bool FlowField::reachable(ivec2 cell) const
+{
+	return distance(cell) != UNREACHABLE;
+}
+
+int FlowField::distance(ivec2 cell) const
+{
+	if (!built || !in_bounds(cell))
+		return UNREACHABLE;
+	return dist[index(cell)];
+}
+
+ivec2 FlowField::next_cell(ivec2 cell) const
+{
+	if (!built || !in_bounds(cell) || dir[index(cell)] == DIR_NONE)
+		return cell;
+	return cell + DIRECTIONS[dir[index(cell)]];
+}
+
+ivec2 FlowField::next_corner(ivec2 cell) const
+{
+	if (!built || !in_bounds(cell) || dir[index(cell)] == DIR_NONE)
+		return cell;
+
+	// follow the straight run to the first cell that turns (or is the exit)
+	const uint8_t d = dir[index(cell)];
+	ivec2 corner = cell + DIRECTIONS[d];
+	while (dir[index(corner)] == d)
+		corner += DIRECTIONS[d];
+	return corner;
+}
+
+vec2 FlowField::nearest_on_lanes(vec2 position, float half_width) const
+{
+	const vec2 cell_size = vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX);
+	const ivec2 cell = ivec2(floor(position / cell_size));
+	if (!built || !reachable(cell))
+		return position;
+
+	// work in offsets from the cell's center, the center square is on every lane
+	const vec2 center = (vec2(cell) + 0.5f) * cell_size;
+	const vec2 offset = position - center;
+	vec2 nearest = clamp(offset, vec2(-half_width), vec2(half_width));
+	if (nearest == offset)
+		return position;
+
+	const int from = index(cell);
+	for (uint8_t d = 0; d < 4; d++) {
+		if (step(from, d) < 0)
+			continue;
+
+		// the arm reaches from the center square out to the cell edge on side d
+		const vec2 edge = vec2(DIRECTIONS[d]) * cell_size / 2.f;
+		const vec2 on_arm = clamp(offset, min(vec2(-half_width), edge), max(vec2(half_width), edge));
+		const vec2 to_arm = on_arm - offset;
+		const vec2 to_nearest = nearest - offset;
+		if (dot(to_arm, to_arm) < dot(to_nearest, to_nearest))
+			nearest = on_arm;
+	}
+	return center + nearest;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "common.hpp"
+#include <utility>
+#include <vector>
+
+// A per-cell direction field pointing toward the nearest exit tile.
+// It is built with one reverse BFS seeded from every exit tile over the tile
+// connectivity (see TILE_BITS), so all invaders share the same O(cells)
+// result instead of running a path search per spawn.
+//
+// Cells can be blocked and unblocked afterwards (towers placed on the path when
+// mazing); the field is then repaired in place, touching only the cells whose
+// distance to the exit actually changes.
+class FlowField
+{
+public:
+	// direction indices follow tiles.hpp: top (0), right (1), bottom (2), left (3)
+	static constexpr uint8_t DIR_NONE = 4;
+	static constexpr int UNREACHABLE = -1;
+
+	// rebuild the field from the current level tiles, cells holding a tower start blocked
+	void build();
+
+	// mark the field stale after a map change, ready() is false until the next build()
+	void invalidate() { built = false; }
+	bool ready() const { return built; }
+
+	// block a cell and repair the field; returns false (and changes nothing) if that
+	// would cut a start tile off from every exit
+	bool block(ivec2 cell);
+
+	// unblock a cell and propagate the shorter routes it opens up
+	void unblock(ivec2 cell);
+
+	bool in_bounds(ivec2 cell) const;
+	bool is_exit(ivec2 cell) const;
+	bool reachable(ivec2 cell) const;
+
+	// number of steps to the nearest exit, UNREACHABLE if there is no route
+	int distance(ivec2 cell) const;
+
+	// the neighbour one step closer to an exit (the cell itself at an exit or when unreachable)
+	ivec2 next_cell(ivec2 cell) const;
+
+	// the end of the straight run that starts at cell: the next cell where the route turns,
+	// or the exit. Walking corner to corner needs one target per turn instead of one per tile.
+	ivec2 next_corner(ivec2 cell) const;
+
+	// the point nearest to position on the lanes of the cell it is in: a square of half_width
+	// around the cell's center plus an arm as wide out through each side the route can cross.
+	// Positions on cells off the field come back unchanged.
+	vec2 nearest_on_lanes(vec2 position, float half_width) const;
+
+	// changes whenever any route may have changed (build, block, unblock), so anything
+	// holding a corner can tell it has to look again
+	uint32_t revision() const { return revision_count; }
+
+private:
+	int index(ivec2 cell) const { return map_grid.index(cell); }
+	ivec2 cell_of(int i) const { return map_grid.cell_of(i); }
+
+	// index of the neighbour in direction d if both tiles open toward each other and neither is blocked, -1 otherwise
+	int step(int from, uint8_t d) const;
+
+	bool built = false;
+	uint32_t revision_count = 0;
+
+	// flat map_grid.wide x map_grid.high grids, row-major
+	std::vector<int> dist;
+	std::vector<uint8_t> dir;
+	std::vector<uint8_t> open;	// bitmask of open tile sides, (1 << direction)
+	std::vector<uint8_t> exits;
+	std::vector<uint8_t> starts;
+	std::vector<uint8_t> blocked;
+
+	// scratch space for repairs, kept to avoid reallocating per edit
+	std::vector<int> affected;
+	std::vector<std::pair<int, uint8_t>> saved;	// dist and dir of the affected cells before the edit
+	std::vector<std::pair<int, int>> frontier;	// (distance, cell) min-heap
+};
+
+extern FlowField flow_field;
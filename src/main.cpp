@@ -11,6 +11,7 @@
 #include "physics_system.hpp"
 #include "render_system.hpp"
 #include "world_system.hpp"
+#include "worker_pool.hpp"
 #include "tinyECS/registry.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
@@ -24,6 +25,9 @@ int main()
 	RenderSystem  renderer_system;
 	PhysicsSystem physics_system;
 
+	// one worker per hardware thread, for both the AI and the physics parallel phases
+	WorkerPool    workers;
+
 	// initialize window
 	GLFWwindow* window = world_system.create_window();
 	if (!window) {
@@ -40,6 +44,8 @@ int main()
 	// initialize the main systems
 	renderer_system.init(window);
 	world_system.init(&renderer_system);
+	ai_system.init(&workers);
+	physics_system.init(&workers);
 
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	// A2: see GAME_SCREEN_ID in components.hpp
@@ -0,0 +1,598 @@
+// internal
+#include "pathing.hpp"
+#include "tile_grid.hpp"
+#include "tiles.hpp"
+
+#include <algorithm>
+
+// offsets for top (0), right (1), bottom (2), left (3)
+static const ivec2 DIRECTIONS[4] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+
+static int index(ivec2 cell) { return map_grid.index(cell); }
+static ivec2 cell_of(int i) { return map_grid.cell_of(i); }
+
+// the neighbour of a cell in direction d if both tiles open toward each other, else -1
+static int step(ivec2 cell, uint8_t d)
+{
+	const ivec2 neighbor = cell + DIRECTIONS[d];
+	if (!tile_grid.has(cell) || !tile_grid.has(neighbor)
+		|| !tiles_connect(tile_grid.tile_id_at(cell), tile_grid.tile_id_at(neighbor), d))
+		return -1;
+	return index(neighbor);
+}
+
+static int manhattan(ivec2 a, ivec2 b)
+{
+	return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+void CellHeap::resize(size_t num_cells)
+{
+	heap.clear();
+	heap.reserve(num_cells);
+	heap_pos.assign(num_cells, -1);
+	keys.resize(num_cells);
+}
+
+void CellHeap::clear()
+{
+	for (int cell : heap)
+		heap_pos[cell] = -1;
+	heap.clear();
+}
+
+void CellHeap::push(int cell, Key key)
+{
+	if (contains(cell)) {
+		const bool decreased = key < keys[cell];
+		keys[cell] = key;
+		if (decreased)
+			sift_up(heap_pos[cell]);
+		else
+			sift_down(heap_pos[cell]);
+		return;
+	}
+	keys[cell] = key;
+	heap.push_back(cell);
+	heap_pos[cell] = (int)heap.size() - 1;
+	sift_up((int)heap.size() - 1);
+}
+
+int CellHeap::pop()
+{
+	const int top = heap.front();
+	remove(top);
+	return top;
+}
+
+void CellHeap::remove(int cell)
+{
+	const int pos = heap_pos[cell];
+	const int last = heap.back();
+	heap.pop_back();
+	heap_pos[cell] = -1;
+	if (last == cell)
+		return;
+
+	// the last cell fills the hole and moves whichever way its key requires
+	place(pos, last);
+	if (pos > 0 && keys[last] < keys[heap[(pos - 1) / 2]])
+		sift_up(pos);
+	else
+		sift_down(pos);
+}
+
+void CellHeap::sift_up(int pos)
+{
+	const int cell = heap[pos];
+	while (pos > 0) {
+		const int up = (pos - 1) / 2;
+		if (!(keys[cell] < keys[heap[up]]))
+			break;
+		place(pos, heap[up]);
+		pos = up;
+	}
+	place(pos, cell);
+}
+
+void CellHeap::sift_down(int pos)
+{
+	const int cell = heap[pos];
+	const int count = (int)heap.size();
+	for (;;) {
+		int child = 2 * pos + 1;
+		if (child >= count)
+			break;
+		if (child + 1 < count && keys[heap[child + 1]] < keys[heap[child]])
+			child++;
+		if (!(keys[heap[child]] < keys[cell]))
+			break;
+		place(pos, heap[child]);
+		pos = child;
+	}
+	place(pos, cell);
+}
+
+bool PathSearch::find(ivec2 start, ivec2 goal, std::vector<ivec2>& path, const std::function<void(ivec2)>& visit)
+{
+	path.clear();
+	if (!tile_grid.has(start) || !tile_grid.has(goal))
+		return false;
+
+	begin();
+	const int start_cell = index(start);
+	const int goal_cell = index(goal);
+
+	stamp[start_cell] = generation;
+	state[start_cell] = OPEN;
+	g[start_cell] = 0;
+	parent[start_cell] = start_cell;
+	open.push(start_cell, { manhattan(start, goal), 0 });
+
+	while (!open.empty()) {
+		const int current = open.pop();
+		state[current] = CLOSED;
+		const ivec2 position = cell_of(current);
+		if (visit)
+			visit(position);
+
+		if (current == goal_cell) {
+			for (int cell = goal_cell; cell != start_cell; cell = parent[cell])
+				path.push_back(cell_of(cell));
+			path.push_back(start);
+			std::reverse(path.begin(), path.end());
+			return true;
+		}
+
+		for (uint8_t d = 0; d < 4; d++) {
+			const int next = step(position, d);
+			if (next < 0)
+				continue;
+
+			const int next_g = g[current] + 1;
+			const uint8_t next_state = state_of(next);
+			// the heuristic is consistent, so closed cells are final
+			if (next_state == CLOSED || (next_state == OPEN && next_g >= g[next]))
+				continue;
+
+			// new, or a cheaper route to a queued cell (decrease-key)
+			stamp[next] = generation;
+			state[next] = OPEN;
+			g[next] = next_g;
+			parent[next] = current;
+			open.push(next, { next_g + manhattan(cell_of(next), goal), -next_g });
+		}
+	}
+
+	return false;
+}
+
+void PathSearch::begin()
+{
+	const size_t num_cells = map_grid.count();
+	if (stamp.size() != num_cells) {
+		stamp.assign(num_cells, 0);
+		state.assign(num_cells, UNSEEN);
+		g.assign(num_cells, 0);
+		parent.assign(num_cells, -1);
+		open.resize(num_cells);
+		generation = 0;
+	}
+
+	// stamps from 2^32 searches ago would look current again
+	if (++generation == 0) {
+		std::fill(stamp.begin(), stamp.end(), 0);
+		generation = 1;
+	}
+	open.clear();
+}
+
+void PathPlanner::reset(ivec2 start, ivec2 goal)
+{
+	const size_t num_cells = map_grid.count();
+	g.assign(num_cells, INF);
+	rhs.assign(num_cells, INF);
+	open.resize(num_cells);
+
+	start_cell = start;
+	goal_cell = goal;
+	rhs[index(start)] = 0;
+	open.push(index(start), key(index(start)));
+	initialized = true;
+}
+
+CellHeap::Key PathPlanner::key(int cell) const
+{
+	const int best = std::min(g[cell], rhs[cell]);
+	return { best + manhattan(cell_of(cell), goal_cell), best };
+}
+
+void PathPlanner::update_cell(int cell)
+{
+	const ivec2 position = cell_of(cell);
+	if (position != start_cell) {
+		rhs[cell] = INF;
+		for (uint8_t d = 0; d < 4; d++) {
+			const int neighbor = step(position, d);
+			if (neighbor >= 0)
+				rhs[cell] = std::min(rhs[cell], g[neighbor] + 1);
+		}
+	}
+
+	if (g[cell] != rhs[cell])
+		open.push(cell, key(cell));
+	else if (open.contains(cell))
+		open.remove(cell);
+}
+
+void PathPlanner::tile_changed(ivec2 cell)
+{
+	if (!initialized || !map_grid.in_bounds(cell))
+		return;
+
+	// only the edges between the cell and its neighbours changed
+	update_cell(index(cell));
+	for (uint8_t d = 0; d < 4; d++) {
+		const ivec2 neighbor = cell + DIRECTIONS[d];
+		if (map_grid.in_bounds(neighbor))
+			update_cell(index(neighbor));
+	}
+}
+
+bool PathPlanner::plan(std::vector<ivec2>& path, const std::function<void(ivec2)>& visit)
+{
+	path.clear();
+	if (!initialized)
+		return false;
+
+	const int goal = index(goal_cell);
+	while (!open.empty() && (open.top_key() < key(goal) || rhs[goal] != g[goal])) {
+		const int current = open.pop();
+		const ivec2 position = cell_of(current);
+		if (visit)
+			visit(position);
+
+		if (g[current] > rhs[current]) {
+			// settled at a shorter distance
+			g[current] = rhs[current];
+		}
+		else {
+			// got longer (or cut off): reopen it and let the neighbours re-derive theirs
+			g[current] = INF;
+			update_cell(current);
+		}
+		for (uint8_t d = 0; d < 4; d++) {
+			const int neighbor = step(position, d);
+			if (neighbor >= 0)
+				update_cell(neighbor);
+		}
+	}
+
+	if (g[goal] >= INF)
+		return false;
+
+	// walk back from the goal, always to the neighbour closest to the start
+	int cell = goal;
+	path.push_back(goal_cell);
+	while (cell_of(cell) != start_cell) {
+		const ivec2 position = cell_of(cell);
+		int best = -1;
+		for (uint8_t d = 0; d < 4; d++) {
+			const int neighbor = step(position, d);
+			if (neighbor >= 0 && (best < 0 || g[neighbor] < g[best]))
+				best = neighbor;
+		}
+		if (best < 0 || g[best] >= g[cell]) {
+			path.clear();
+			return false;
+		}
+		cell = best;
+		path.push_back(cell_of(cell));
+	}
+	std::reverse(path.begin(), path.end());
+	return true;
+}
+
+// runs of crossings at least this long get an entrance at each end instead of one in the middle
+static const int LONG_ENTRANCE = 6;
+
+void PathHierarchy::tile_changed(ivec2 cell)
+{
+	if (!built || !map_grid.in_bounds(cell))
+		return;
+
+	auto mark = [this](int k) {
+		if (!clusters[k].dirty) {
+			clusters[k].dirty = true;
+			dirty.push_back(k);
+		}
+	};
+
+	// the cluster itself, and across any border the cell lies on, whose entrances may have moved
+	const int k = cluster_of(cell);
+	const ivec2 local = { cell.x % PATH_CLUSTER_CELLS, cell.y % PATH_CLUSTER_CELLS };
+	const ivec2 cluster = { k % clusters_wide, k / clusters_wide };
+	mark(k);
+	if (local.x == 0 && cluster.x > 0)
+		mark(k - 1);
+	if (local.x == PATH_CLUSTER_CELLS - 1 && cluster.x + 1 < clusters_wide)
+		mark(k + 1);
+	if (local.y == 0 && cluster.y > 0)
+		mark(k - clusters_wide);
+	if (local.y == PATH_CLUSTER_CELLS - 1 && cluster.y + 1 < clusters_high)
+		mark(k + clusters_wide);
+}
+
+void PathHierarchy::update()
+{
+	const size_t num_cells = map_grid.count();
+	if (!built || node_slot.size() != num_cells) {
+		clusters_wide = (map_grid.wide + PATH_CLUSTER_CELLS - 1) / PATH_CLUSTER_CELLS;
+		clusters_high = (map_grid.high + PATH_CLUSTER_CELLS - 1) / PATH_CLUSTER_CELLS;
+		clusters.assign(clusters_wide * clusters_high, Cluster());
+		node_slot.assign(num_cells, -1);
+
+		flood_stamp.assign(num_cells, 0);
+		flood_dist.assign(num_cells, 0);
+		flood_parent.assign(num_cells, -1);
+		flood_queue.reserve(PATH_CLUSTER_CELLS * PATH_CLUSTER_CELLS);
+		flood_generation = 0;
+
+		stamp.assign(num_cells, 0);
+		closed.assign(num_cells, 0);
+		g.assign(num_cells, 0);
+		parent.assign(num_cells, -1);
+		open.resize(num_cells);
+		generation = 0;
+
+		dirty.clear();
+		for (int k = 0; k < (int)clusters.size(); k++)
+			dirty.push_back(k);
+		built = true;
+	}
+
+	for (int k : dirty) {
+		rebuild(k);
+		clusters[k].dirty = false;
+	}
+	dirty.clear();
+}
+
+void PathHierarchy::rebuild(int k)
+{
+	Cluster& cluster = clusters[k];
+	for (int cell : cluster.nodes)
+		node_slot[cell] = -1;
+	cluster.nodes.clear();
+
+	// right and bottom borders belong to this cluster, left and top to the neighbours
+	const int cx = k % clusters_wide;
+	const int cy = k / clusters_wide;
+	if (cx + 1 < clusters_wide)
+		add_entrances(k, 1, k);
+	if (cx > 0)
+		add_entrances(k - 1, 1, k);
+	if (cy + 1 < clusters_high)
+		add_entrances(k, 2, k);
+	if (cy > 0)
+		add_entrances(k - clusters_wide, 2, k);
+
+	const size_t n = cluster.nodes.size();
+	cluster.dist.assign(n * n, INF);
+	for (size_t i = 0; i < n; i++) {
+		flood(cluster.nodes[i]);
+		for (size_t j = 0; j < n; j++) {
+			if (flooded(cluster.nodes[j]))
+				cluster.dist[i * n + j] = flood_dist[cluster.nodes[j]];
+		}
+	}
+}
+
+void PathHierarchy::add_entrances(int k, uint8_t d, int side)
+{
+	// the last line of cells in cluster k, the crossings go from it in direction d,
+	// and along it in direction along
+	const ivec2 origin = { (k % clusters_wide) * PATH_CLUSTER_CELLS, (k / clusters_wide) * PATH_CLUSTER_CELLS };
+	const uint8_t along = (d == 1) ? 2 : 1;
+	const ivec2 first = origin + (d == 1 ? ivec2(PATH_CLUSTER_CELLS - 1, 0) : ivec2(0, PATH_CLUSTER_CELLS - 1));
+	const int length = (d == 1) ? std::min(PATH_CLUSTER_CELLS, map_grid.high - origin.y)
+		: std::min(PATH_CLUSTER_CELLS, map_grid.wide - origin.x);
+
+	auto inner = [&](int i) { return first + DIRECTIONS[along] * i; };
+	auto crossing = [&](int i) { return i < length && step(inner(i), d) >= 0; };
+
+	int run_start = -1;
+	for (int i = 0; i <= length; i++) {
+		const bool crosses = crossing(i);
+		// a run goes on while the cells on both sides also connect to the previous ones
+		const bool continues = crosses && run_start >= 0
+			&& step(inner(i - 1), along) >= 0 && step(inner(i - 1) + DIRECTIONS[d], along) >= 0;
+
+		if (run_start >= 0 && !continues) {
+			const int run_end = i - 1;
+			const int picks[2] = { run_start, run_end };
+			const bool both_ends = run_end - run_start + 1 >= LONG_ENTRANCE;
+			for (int p = 0; p < (both_ends ? 2 : 1); p++) {
+				const ivec2 cell = inner(both_ends ? picks[p] : (run_start + run_end) / 2);
+				add_node(side, index(side == k ? cell : cell + DIRECTIONS[d]));
+			}
+			run_start = -1;
+		}
+		if (crosses && run_start < 0)
+			run_start = i;
+	}
+}
+
+void PathHierarchy::add_node(int k, int cell)
+{
+	Cluster& cluster = clusters[k];
+	if (node_slot[cell] >= 0)
+		return;
+	node_slot[cell] = (int)cluster.nodes.size();
+	cluster.nodes.push_back(cell);
+}
+
+void PathHierarchy::flood(int source, int target)
+{
+	if (++flood_generation == 0) {
+		std::fill(flood_stamp.begin(), flood_stamp.end(), 0);
+		flood_generation = 1;
+	}
+
+	const int k = cluster_of(cell_of(source));
+	flood_queue.clear();
+	flood_queue.push_back(source);
+	flood_stamp[source] = flood_generation;
+	flood_dist[source] = 0;
+	flood_parent[source] = source;
+
+	for (size_t head = 0; head < flood_queue.size(); head++) {
+		const int current = flood_queue[head];
+		if (current == target)
+			return;
+		const ivec2 position = cell_of(current);
+		for (uint8_t d = 0; d < 4; d++) {
+			const int next = step(position, d);
+			if (next < 0 || flooded(next) || cluster_of(cell_of(next)) != k)
+				continue;
+			flood_stamp[next] = flood_generation;
+			flood_dist[next] = flood_dist[current] + 1;
+			flood_parent[next] = current;
+			flood_queue.push_back(next);
+		}
+	}
+}
+
+void PathHierarchy::begin_search()
+{
+	if (++generation == 0) {
+		std::fill(stamp.begin(), stamp.end(), 0);
+		generation = 1;
+	}
+	open.clear();
+}
+
+void PathHierarchy::relax(int from, int to, int cost, ivec2 goal)
+{
+	const int next_g = g[from] + cost;
+	if (stamp[to] == generation && (closed[to] || next_g >= g[to]))
+		return;
+	stamp[to] = generation;
+	closed[to] = 0;
+	g[to] = next_g;
+	parent[to] = from;
+	open.push(to, { next_g + manhattan(cell_of(to), goal), -next_g });
+}
+
+bool PathHierarchy::find_waypoints(ivec2 start, ivec2 goal, std::vector<ivec2>& waypoints,
+	const std::function<void(ivec2)>& visit)
+{
+	waypoints.clear();
+	if (!tile_grid.has(start) || !tile_grid.has(goal))
+		return false;
+	if (start == goal) {
+		waypoints.push_back(start);
+		return true;
+	}
+
+	update();
+	const int start_cell = index(start);
+	const int goal_cell = index(goal);
+	const int goal_cluster = cluster_of(goal);
+
+	// link the start to the entrances of its cluster, and straight to the goal if it is in there too
+	flood(start_cell);
+	start_links.clear();
+	for (int node : clusters[cluster_of(start)].nodes) {
+		if (flooded(node))
+			start_links.push_back({ node, flood_dist[node] });
+	}
+	if (flooded(goal_cell) && cluster_of(start) == goal_cluster)
+		start_links.push_back({ goal_cell, flood_dist[goal_cell] });
+
+	// and the entrances of the goal's cluster to the goal
+	flood(goal_cell);
+	goal_dist.clear();
+	for (int node : clusters[goal_cluster].nodes)
+		goal_dist.push_back(flooded(node) ? flood_dist[node] : INF);
+
+	begin_search();
+	stamp[start_cell] = generation;
+	closed[start_cell] = 0;
+	g[start_cell] = 0;
+	parent[start_cell] = start_cell;
+	open.push(start_cell, { manhattan(start, goal), 0 });
+
+	while (!open.empty()) {
+		const int current = open.pop();
+		closed[current] = 1;
+		if (visit)
+			visit(cell_of(current));
+
+		if (current == goal_cell) {
+			for (int cell = goal_cell; cell != start_cell; cell = parent[cell])
+				waypoints.push_back(cell_of(cell));
+			waypoints.push_back(start);
+			std::reverse(waypoints.begin(), waypoints.end());
+			return true;
+		}
+
+		if (current == start_cell) {
+			for (const auto& link : start_links)
+				relax(current, link.first, link.second, goal);
+		}
+
+		const int slot = node_slot[current];
+		if (slot < 0)
+			continue;
+
+		// across the cluster, across an entrance, and into the goal
+		const ivec2 position = cell_of(current);
+		const int k = cluster_of(position);
+		const Cluster& cluster = clusters[k];
+		const size_t n = cluster.nodes.size();
+		for (size_t j = 0; j < n; j++) {
+			const int cost = cluster.dist[slot * n + j];
+			if (cost < INF && (int)j != slot)
+				relax(current, cluster.nodes[j], cost, goal);
+		}
+		for (uint8_t d = 0; d < 4; d++) {
+			const int next = step(position, d);
+			if (next >= 0 && node_slot[next] >= 0 && cluster_of(cell_of(next)) != k)
+				relax(current, next, 1, goal);
+		}
+		if (k == goal_cluster && goal_dist[slot] < INF)
+			relax(current, goal_cell, goal_dist[slot], goal);
+	}
+
+	return false;
+}
+
+bool PathHierarchy::refine(ivec2 from, ivec2 to, std::vector<ivec2>& path)
+{
+	// an entrance is a single step between clusters
+	if (cluster_of(from) != cluster_of(to)) {
+		if (manhattan(from, to) != 1)
+			return false;
+		for (uint8_t d = 0; d < 4; d++) {
+			if (from + DIRECTIONS[d] == to && step(from, d) >= 0) {
+				path.push_back(to);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	update();
+	const int from_cell = index(from);
+	const int to_cell = index(to);
+	flood(from_cell, to_cell);
+	if (!flooded(to_cell))
+		return false;
+
+	const size_t first = path.size();
+	for (int cell = to_cell; cell != from_cell; cell = flood_parent[cell])
+		path.push_back(cell_of(cell));
+	std::reverse(path.begin() + first, path.end());
+	return true;
+}
@@ -1,21 +1,192 @@
 #pragma once
 
 #include "common.hpp"
-#include <functional> 
+#include <climits>
+#include <functional>
+#include <vector>
 
+// Binary min-heap of grid cells that knows where each cell sits, so a queued cell can
+// have its key changed or be taken out in place instead of being pushed again.
+// Keys compare on first, then second.
+class CellHeap
+{
+public:
+	struct Key {
+		int first;
+		int second;
+		bool operator<(const Key& rhs) const { return first < rhs.first || (first == rhs.first && second < rhs.second); }
+	};
 
-// A2: simple A-star node
-struct Node {
-	uint G, H, F;
-	ivec2 position;
-	ivec2 parent;
+	// size the per-cell index, every cell starts out of the heap
+	void resize(size_t num_cells);
+	void clear();
 
-	Node(ivec2 position_, ivec2 parent_, uint g_, uint h_) : position(position_), parent(parent_), G(g_), H(h_) { F = G + H; };
+	bool empty() const { return heap.empty(); }
+	bool contains(int cell) const { return heap_pos[cell] >= 0; }
+	int top() const { return heap.front(); }
+	Key top_key() const { return keys[heap.front()]; }
 
-	uint get_score() const { return G + H; }
-	
-	bool operator==(const Node& rhs) { return this->position == rhs.position; }
+	// queue a cell, or move it to its new key if already queued
+	void push(int cell, Key key);
+	int pop();
+	void remove(int cell);
 
-	bool operator==(const ivec2& pos) { return this->position == pos; }
+private:
+	void sift_up(int pos);
+	void sift_down(int pos);
+	void place(int pos, int cell) { heap[pos] = cell; heap_pos[cell] = pos; }
+
+	std::vector<int> heap;
+	std::vector<int> heap_pos;		// -1 for cells not in the heap
+	std::vector<Key> keys;			// per cell, valid while queued
+};
+
+// A2: A* over the level tiles (see tile_grid.hpp), from one cell to another.
+// The search keeps its state in flat per-cell arrays that are reused across calls:
+// a generation stamp marks which entries belong to the current search, so nothing is
+// cleared or allocated once the arrays have grown to the grid size. The open list is
+// an indexed heap, so a cheaper route to a queued cell updates it in place instead of
+// pushing a duplicate. Every step costs one and the heuristic is the Manhattan
+// distance, which never overestimates on the 4-connected grid.
+class PathSearch
+{
+public:
+	// fills path start..goal and returns true if one exists; visit, when set, is called
+	// with each cell as it is expanded (the tiles the search looked at)
+	bool find(ivec2 start, ivec2 goal, std::vector<ivec2>& path,
+		const std::function<void(ivec2)>& visit = nullptr);
+
+private:
+	static constexpr uint8_t UNSEEN = 0;
+	static constexpr uint8_t OPEN = 1;
+	static constexpr uint8_t CLOSED = 2;
+
+	void begin();
+	uint8_t state_of(int cell) const { return stamp[cell] == generation ? state[cell] : UNSEEN; }
+
+	uint32_t generation = 0;
+	std::vector<uint32_t> stamp;	// entries of a cell are valid only if its stamp is the current generation
+	std::vector<uint8_t> state;
+	std::vector<int> g;
+	std::vector<int> parent;
+	CellHeap open;					// on f, ties go to the larger g (the cell closer to the goal)
+};
+
+// Lifelong planning A* (LPA*) between a fixed start and goal, for the path overlay while
+// a level is being drawn. It keeps g (distance from the start as last settled) and rhs
+// (the one-step lookahead from the neighbours) for every cell between plans. A tile edit
+// only re-evaluates the edited cell and its neighbours, and the next plan() expands
+// just the cells whose distance actually changed and that could matter for the goal;
+// an edit far off the current path is queued behind the goal and never expanded.
+class PathPlanner
+{
+public:
+	// true if the planner holds state for this start and goal
+	bool matches(ivec2 start, ivec2 goal) const { return initialized && start == start_cell && goal == goal_cell; }
+
+	// drop all state, the next reset() starts over
+	void invalidate() { initialized = false; }
+
+	// start planning from scratch between start and goal
+	void reset(ivec2 start, ivec2 goal);
+
+	// the tile in cell was placed, removed or replaced; cheap, the repair happens in plan()
+	void tile_changed(ivec2 cell);
+
+	// bring the search up to date and fill path start..goal; visit, when set, is called
+	// with each cell expanded by this repair
+	bool plan(std::vector<ivec2>& path, const std::function<void(ivec2)>& visit = nullptr);
+
+private:
+	static constexpr int INF = INT_MAX / 2;
+
+	CellHeap::Key key(int cell) const;
+	void update_cell(int cell);
+
+	bool initialized = false;
+	ivec2 start_cell = { 0, 0 };
+	ivec2 goal_cell = { 0, 0 };
+	std::vector<int> g;
+	std::vector<int> rhs;
+	CellHeap open;					// the inconsistent cells (g != rhs)
 };
 
+// Hierarchical A* (HPA*) for large maps. The map is cut into square clusters of
+// PATH_CLUSTER_CELLS a side. Where tiles connect across the border of two clusters the
+// crossing is an entrance; a run of crossings whose cells also connect along the border on
+// both sides is one entrance, with a crossing at the middle (or at both ends if the run is
+// long). The cells of the entrances are the nodes of an abstract graph, with an edge across
+// each entrance and, inside a cluster, one between every pair of its nodes holding the
+// shortest distance within the cluster. A query links start and goal into their clusters
+// and searches the abstract graph, returning only the waypoints. Refinement is lazy: the
+// caller turns one leg into tiles with refine(), a search bounded to a single cluster, as
+// it gets to that leg, so a route never has to exist as a full tile list.
+// A tile edit marks its cluster dirty, and the neighbouring cluster too when the tile sits
+// on their shared border; only the dirty clusters are rebuilt, at the next query.
+// Distances inside a cluster ignore detours through other clusters, so a route can come
+// out a little longer than the shortest one, but one is always found if it exists.
+class PathHierarchy
+{
+public:
+	// forget every cluster, the next query rebuilds them all for the current map_grid
+	void invalidate() { built = false; }
+
+	// the tile in cell was placed, removed or replaced
+	void tile_changed(ivec2 cell);
+
+	// the abstract route: start, the entrance cells passed through, goal; visit, when set,
+	// is called with each cell the abstract search expands
+	bool find_waypoints(ivec2 start, ivec2 goal, std::vector<ivec2>& waypoints,
+		const std::function<void(ivec2)>& visit = nullptr);
+
+	// appends the tiles after from up to and including to, two consecutive waypoints
+	bool refine(ivec2 from, ivec2 to, std::vector<ivec2>& path);
+
+private:
+	static constexpr int INF = INT_MAX / 2;
+
+	struct Cluster {
+		std::vector<int> nodes;		// cells of its entrances
+		std::vector<int> dist;		// nodes x nodes, INF where one cannot reach the other inside the cluster
+		bool dirty = true;
+	};
+
+	int cluster_of(ivec2 cell) const { return (cell.y / PATH_CLUSTER_CELLS) * clusters_wide + cell.x / PATH_CLUSTER_CELLS; }
+
+	void update();
+	void rebuild(int k);
+	// adds the entrances on the border between cluster k and the one in direction d (1 or 2)
+	// to the nodes of whichever of the two is side
+	void add_entrances(int k, uint8_t d, int side);
+	void add_node(int k, int cell);
+
+	// breadth first from source without leaving its cluster, stops early once target is reached
+	void flood(int source, int target = -1);
+	bool flooded(int cell) const { return flood_stamp[cell] == flood_generation; }
+
+	void begin_search();
+	void relax(int from, int to, int cost, ivec2 goal);
+
+	bool built = false;
+	int clusters_wide = 0;
+	int clusters_high = 0;
+	std::vector<Cluster> clusters;
+	std::vector<int> dirty;			// clusters to rebuild before the next query
+	std::vector<int> node_slot;		// per cell, its index in its cluster's nodes or -1
+
+	uint32_t flood_generation = 0;
+	std::vector<uint32_t> flood_stamp;
+	std::vector<int> flood_dist;
+	std::vector<int> flood_parent;
+	std::vector<int> flood_queue;
+
+	// the abstract search, over node cells
+	uint32_t generation = 0;
+	std::vector<uint32_t> stamp;
+	std::vector<uint8_t> closed;
+	std::vector<int> g;
+	std::vector<int> parent;
+	CellHeap open;
+	std::vector<std::pair<int, int>> start_links;	// node cell, distance from the start
+	std::vector<int> goal_dist;						// per node slot of the goal's cluster, distance to the goal
+};
@@ -2,107 +2,367 @@
 #include "physics_system.hpp"
 #include "world_system.hpp"
 #include "world_init.hpp"
+#include "flow_field.hpp"
+#include "projectile_pool.hpp"
+#include "static_layer.hpp"
+#include <algorithm>
 #include <iostream>
 
 
-// Returns the local bounding coordinates scaled by the current size of the entity
-vec2 get_bounding_box(const Motion& motion)
+// Exact overlap tests for a batch of candidate pairs in SoA form. Both shapes are
+// folded into one box rounded by a radius (a circle is a zero-size box, an AABB has
+// no rounding), so circle/circle, circle/AABB and AABB/AABB share the same branch-free
+// test: the offset between the centers has to lie inside that rounded box.
+static void overlap_batch(int count, const float* dx, const float* dy,
+                          const float* hx, const float* hy, const float* r, uint8_t* hit)
 {
-	// abs is to avoid negative scale due to the facing direction.
-	return { abs(motion.scale.x), abs(motion.scale.y) };
+    for (int k = 0; k < count; k++) {
+        float qx = abs(dx[k]) - hx[k];
+        float qy = abs(dy[k]) - hy[k];
+        float ox = max(qx, 0.f);
+        float oy = max(qy, 0.f);
+        // strictly inside the box, or within the radius of its edge (boxes that only touch do not overlap)
+        hit[k] = (uint8_t)((max(qx, qy) < 0.f) | (ox * ox + oy * oy < r[k] * r[k]));
+    }
 }
 
-// This is a SUPER APPROXIMATE check that puts a circle around the bounding boxes and sees
-// if the center point of either object is inside the other's bounding-box-circle. You can
-// surely implement a more accurate detection
-bool collides(const Motion& motion1, const Motion& motion2)
+// candidate pairs are tested in batches of this size
+static const int NARROWPHASE_BATCH = 64;
+
+// Gathers the candidate pairs batch by batch into flat arrays, tests them and keeps the hits.
+// The first index of a pair refers to the a arrays, the second to the b arrays.
+static void narrowphase(const std::vector<std::pair<int, int>>& candidates,
+                        const std::vector<vec2>& position_a, const std::vector<vec2>& half_a, const std::vector<float>& radius_a,
+                        const std::vector<vec2>& position_b, const std::vector<vec2>& half_b, const std::vector<float>& radius_b,
+                        std::vector<std::pair<int, int>>& out)
 {
-	vec2 dp = motion1.position - motion2.position;
-	float dist_squared = dot(dp,dp);
-	const vec2 other_bonding_box = get_bounding_box(motion1) / 2.f;
-	const float other_r_squared = dot(other_bonding_box, other_bonding_box);
-	const vec2 my_bonding_box = get_bounding_box(motion2) / 2.f;
-	const float my_r_squared = dot(my_bonding_box, my_bonding_box);
-	const float r_squared = max(other_r_squared, my_r_squared);
-	if (dist_squared < r_squared)
-		return true;
-	return false;
+    float dx[NARROWPHASE_BATCH], dy[NARROWPHASE_BATCH];
+    float hx[NARROWPHASE_BATCH], hy[NARROWPHASE_BATCH], r[NARROWPHASE_BATCH];
+    uint8_t hit[NARROWPHASE_BATCH];
+    for (size_t first = 0; first < candidates.size(); first += NARROWPHASE_BATCH) {
+        const int count = (int)std::min<size_t>(NARROWPHASE_BATCH, candidates.size() - first);
+        for (int k = 0; k < count; k++) {
+            const auto [a, b] = candidates[first + k];
+            dx[k] = position_a[a].x - position_b[b].x;
+            dy[k] = position_a[a].y - position_b[b].y;
+            hx[k] = half_a[a].x + half_b[b].x;
+            hy[k] = half_a[a].y + half_b[b].y;
+            r[k] = radius_a[a] + radius_b[b];
+        }
+        overlap_batch(count, dx, dy, hx, hy, r, hit);
+        for (int k = 0; k < count; k++) {
+            if (hit[k])
+                out.push_back(candidates[first + k]);
+        }
+    }
+}
+
+// Point each invader at the next corner of its route through the flow field. A straight
+// run is a single target, so the target changes once per turn instead of once per tile.
+void PhysicsSystem::steer_invaders() {
+    for (int i = (int)registry.invaders.entities.size() - 1; i >= 0; i--) {
+        Entity entity = registry.invaders.entities[i];
+        if (!registry.flowCursors.has(entity))
+            continue;
+
+        Motion& motion = registry.motions.get(entity);
+        FlowCursor& cursor = registry.flowCursors.get(entity);
+        if (cursor.reached_exit) {
+            // The invader made it through, remove it.
+            registry.remove_all_components_of(entity);
+            continue;
+        }
+        if (!flow_field.ready())
+            continue;
+
+        // Knocked off the field (e.g. its tile was removed), the routes changed under a corner
+        // picked earlier (a tower went down on the run), or the crowd pushed it onto a side
+        // branch off the run, where heading straight for the corner would leave its lanes:
+        // re-seek from the tile it is on.
+        ivec2 here = ivec2(motion.position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX));
+        bool off_run = here.x != cursor.cell.x && here.y != cursor.cell.y;
+        if (!flow_field.reachable(cursor.cell) || cursor.field_revision != flow_field.revision() || off_run) {
+            if (flow_field.reachable(here))
+                cursor.cell = here;
+            cursor.field_revision = flow_field.revision();
+        }
+
+        // Compute the center of the tile the field points at.
+        vec2 next_position = vec2(
+            cursor.cell.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f,
+            cursor.cell.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f
+        );
+
+        // No snapping onto the center, the crowd pass keeps neighbours apart and
+        // would have to undo it, so a tile counts as reached anywhere on the square
+        // where its lanes cross. Every way through or around the corner passes it.
+        vec2 from_center = abs(motion.position - next_position);
+        if (max(from_center.x, from_center.y) <= INVADER_LANE_HALF_WIDTH) {
+            if (flow_field.is_exit(cursor.cell)) {
+                cursor.reached_exit = true;
+                motion.velocity = { 0, 0 };
+                continue;
+            }
+            cursor.cell = flow_field.next_corner(cursor.cell);
+            next_position = vec2(
+                cursor.cell.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f,
+                cursor.cell.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f
+            );
+        }
+
+        // Compute direction from current position toward the target. Looking at most one
+        // cell ahead along the run steers an invader that was pushed aside back onto the
+        // center line of its lane, rather than closing in on it at a shallow angle.
+        const vec2 cell_size = vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX);
+        vec2 to_target = clamp(next_position - motion.position, -cell_size, cell_size);
+        float length = glm::length(to_target);
+        motion.velocity = length > 0.f ? to_target / length * INVADER_SPEED : vec2(0, 0);
+    }
+}
+
+// Separation and avoidance for dense waves. Invaders spawn on the same spot and
+// follow the same field, so without this they stack exactly on top of each other.
+// Neighbours come from a uniform grid with INVADER_BB_WIDTH cells and each invader
+// looks at no more than CROWD_MAX_NEIGHBOURS of them, O(n*k) instead of O(n^2).
+// The push itself is not bounded: keep_on_lanes() then holds every invader within
+// INVADER_LANE_HALF_WIDTH (12 px) of its lane's center line, so a crowd spreads
+// along the lane and never onto the cells beside it.
+void PhysicsSystem::separate_crowd() {
+    const size_t count = registry.invaders.entities.size();
+    crowd_positions.resize(count);
+    crowd_velocities.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const Motion& motion = registry.motions.get(registry.invaders.entities[i]);
+        crowd_positions[i] = motion.position;
+        crowd_velocities[i] = motion.velocity;
+    }
+    crowd_grid.build(crowd_positions, INVADER_BB_WIDTH);
+
+    const float radius = CROWD_SEPARATION_RADIUS;
+    for (size_t i = 0; i < count; i++) {
+        const vec2 position = crowd_positions[i];
+        const vec2 seek = crowd_velocities[i];
+        const float seek_speed = glm::length(seek);
+        const vec2 heading = seek_speed > 0.f ? seek / seek_speed : vec2(0, 0);
+
+        vec2 push = { 0, 0 };
+        float brake = 1.f;
+        int neighbours = 0;
+        crowd_grid.query(position, radius, [&](int j) {
+            if ((size_t)j == i)
+                return true;
+
+            vec2 away = position - crowd_positions[j];
+            float dist = glm::length(away);
+            if (dist >= radius)
+                return true;
+
+            // exactly stacked (same spawn point): split them along a fixed per-pair direction
+            if (dist < 0.001f) {
+                float a = (float)(i < (size_t)j ? i : j) * 2.39996f + (i < (size_t)j ? 0.f : (float)M_PI);
+                away = vec2(cos(a), sin(a));
+                dist = 0.001f;
+            }
+            else {
+                away /= dist;
+            }
+            push += away * (1.f - dist / radius);
+
+            // avoidance: queue up behind a neighbour that is in the way instead of pushing through it
+            if (dot(-away, heading) > 0.5f)
+                brake = min(brake, max(dist / radius, 0.25f));
+
+            return ++neighbours < CROWD_MAX_NEIGHBOURS;
+        });
+
+        if (neighbours == 0)
+            continue;
+
+        vec2 velocity = seek * brake + push * (CROWD_SEPARATION_WEIGHT * INVADER_SPEED);
+        float speed = glm::length(velocity);
+        if (speed > INVADER_SPEED)
+            velocity *= INVADER_SPEED / speed;
+        registry.motions.get(registry.invaders.entities[i]).velocity = velocity;
+    }
+}
+
+// Crowd pushes move invaders off the center of their lane, and on a dense wave that
+// drift used to build up until bodies reached towers on the next cell. After moving,
+// every invader is put back on the nearest point of its tile's lanes, so it stays
+// within INVADER_LANE_HALF_WIDTH of a lane center line and corners are only cut
+// inside the corner tile.
+void PhysicsSystem::keep_on_lanes() {
+    if (!flow_field.ready())
+        return;
+
+    for (Entity entity : registry.invaders.entities) {
+        Motion& motion = registry.motions.get(entity);
+        motion.position = flow_field.nearest_on_lanes(motion.position, INVADER_LANE_HALF_WIDTH);
+    }
 }
 
 void PhysicsSystem::physics_step(float elapsed_ms) {
     auto& motion_registry = registry.motions;
     float step_seconds = elapsed_ms / 1000.f;
 
+    steer_invaders();
+    separate_crowd();
+
     for (int i = (int)motion_registry.components.size() - 1; i >= 0; i--) {
         Motion& motion = motion_registry.components[i];
-        Entity entity = motion_registry.entities[i];
-
-        if (registry.invaders.has(entity)) {
-            if (registry.walkingPaths.has(entity)) {
-                WalkingPath& path = registry.walkingPaths.get(entity);
-                if (!path.path.empty()) {
-                    // Compute the center of the next tile in the path.
-                    glm::ivec2 next_tile = path.path.front();
-                    vec2 next_position = vec2(
-                        next_tile.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f,
-                        next_tile.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f
-                    );
-                    // Compute direction from current position toward the target.
-                    vec2 direction = glm::normalize(next_position - motion.position);
-                    motion.velocity = direction * 100.f;  // Use desired invader speed.
-
-                    if (glm::distance(motion.position, next_position) < 1.f) {
-                        motion.position = next_position;
-                        path.path.erase(path.path.begin());
-                    }
-                }
-                else {
-                    // If the path is empty, remove the invader.
-                    registry.remove_all_components_of(entity);
-                    registry.invaders.remove(entity);
-                    continue;
-                }
-            }
-           
-        }
+
+        // Tiles and towers never move.
+        if (registry.staticBodies.has(motion_registry.entities[i]))
+            continue;
 
         // Update position.
         motion.position += motion.velocity * step_seconds;
+    }
+    keep_on_lanes();
 
-        // If this entity is a projectile, remove it if it's off-screen.
-        if (registry.projectiles.has(entity)) {
-            if (motion.position.x < 0 || motion.position.x > WINDOW_WIDTH_PX ||
-                motion.position.y < 0 || motion.position.y > WINDOW_HEIGHT_PX) {
+    // Pooled projectiles: move them and return the ones that left the map.
+    const vec2 map_size = map_grid.size_px();
+    for (size_t slot = 0; slot < projectile_pool.capacity(); slot++) {
+        if (!projectile_pool.is_active((int)slot))
+            continue;
 
-                registry.remove_all_components_of(entity);
-                continue;
-            }
+        Motion& motion = projectile_pool.motions[slot];
+        motion.position += motion.velocity * step_seconds;
+        if (motion.position.x < 0 || motion.position.x > map_size.x ||
+            motion.position.y < 0 || motion.position.y > map_size.y) {
+            projectile_pool.release((int)slot);
         }
     }
-    ComponentContainer<Motion>& motion_container = registry.motions;
-    for (uint i = 0; i < motion_container.components.size(); i++)
-    {
-        Motion& motion_i = motion_container.components[i];
-        Entity entity_i = motion_container.entities[i];
-
-        // note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-        for (uint j = i + 1; j < motion_container.components.size(); j++)
-        {
-            Motion& motion_j = motion_container.components[j];
-            Entity entity_j = motion_container.entities[j];
-            if (collides(motion_i, motion_j))
-            {
-                Entity entity_j = motion_container.entities[j];
-                // Create a collisions event
-                // We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-                // CK: why the duplication, except to allow searching by entity_id
-                registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-                registry.collisions.emplace_with_duplicates(entity_j, entity_i);
-            }
+
+    detect_collisions();
+}
+
+// Broadphase over a uniform grid, then the narrowphase per cell on the worker pool.
+// Only invaders and projectiles go through the grid; towers are static and are looked
+// up in the prebuilt static layer instead. Nothing else has a collision handler.
+// The contacts are sorted by entity pair once they are all in, so what
+// handle_collisions sees does not depend on the number of threads.
+void PhysicsSystem::detect_collisions() {
+    registry.contacts.clear();
+    body_entities.clear();
+    body_ids.clear();
+    body_layers.clear();
+    body_positions.clear();
+    body_half_extents.clear();
+    body_radii.clear();
+
+    float max_extent = 0.f;
+    auto add_body = [&](Entity entity, const Motion& motion, const Collider& collider, COLLISION_LAYER layer) {
+        body_entities.push_back(entity);
+        body_ids.push_back(entity.id());
+        body_layers.push_back(layer);
+        body_positions.push_back(motion.position);
+        if (collider.shape == COLLIDER_SHAPE::CIRCLE) {
+            body_half_extents.push_back({ 0, 0 });
+            body_radii.push_back(collider.radius);
+            max_extent = max(max_extent, collider.radius);
+        }
+        else {
+            body_half_extents.push_back(collider.half_extents);
+            body_radii.push_back(0.f);
+            max_extent = max(max_extent, max(collider.half_extents.x, collider.half_extents.y));
         }
+    };
+    for (Entity invader : registry.invaders.entities)
+        add_body(invader, registry.motions.get(invader), registry.colliders.get(invader), COLLISION_LAYER::INVADER);
+    for (size_t slot = 0; slot < projectile_pool.capacity(); slot++) {
+        if (projectile_pool.is_active((int)slot))
+            add_body(projectile_pool.entities[slot], projectile_pool.motions[slot], projectile_pool.colliders[slot], COLLISION_LAYER::PROJECTILE);
     }
-   
+    if (body_positions.empty())
+        return;
 
-}
+    if (!static_layer.ready())
+        static_layer.build();
+
+    // overlapping bodies are less than the sum of their extents apart on each axis, so with
+    // cells twice the largest extent every contact is between the same or adjacent cells
+    body_grid.build(body_positions, max(2.f * max_extent, 1.f));
+
+    worker_candidates.resize(workers->size());
+    worker_contacts.resize(workers->size());
+    worker_static_candidates.resize(workers->size());
+    worker_static_contacts.resize(workers->size());
+
+    // each cell is tested against itself and its forward neighbours, so every pair is seen once
+    static const ivec2 FORWARD[4] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+    const int cells_wide = body_grid.cells_wide;
+    const int cells_high = body_grid.cells_high;
+    const std::vector<int>& occupied = body_grid.occupied;
+    const size_t min_cells_per_worker = body_positions.size() < NARROWPHASE_PARALLEL_MIN_BODIES ? occupied.size() : 1;
+
+    // only the cells holding bodies, the grid itself may be far larger than the crowd
+    workers->parallel_for(occupied.size(), min_cells_per_worker, [&](size_t worker, size_t begin, size_t end) {
+        std::vector<std::pair<int, int>>& candidates = worker_candidates[worker];
+        std::vector<std::pair<int, int>>& out = worker_contacts[worker];
+        std::vector<std::pair<int, int>>& static_candidates = worker_static_candidates[worker];
+        std::vector<std::pair<int, int>>& static_out = worker_static_contacts[worker];
+        candidates.clear();
+        out.clear();
+        static_candidates.clear();
+        static_out.clear();
+
+        const std::vector<int>& cell_start = body_grid.cell_start;
+        const std::vector<int>& items = body_grid.items;
+        auto add_candidate = [&](int a, int b) {
+            // contacts within a layer are never handled
+            if (body_layers[a] == body_layers[b])
+                return;
+            candidates.push_back(body_layers[a] < body_layers[b] ? std::make_pair(a, b) : std::make_pair(b, a));
+        };
+
+        for (size_t k = begin; k < end; k++) {
+            const int cell = occupied[k];
+            const int cx = cell % cells_wide;
+            const int cy = cell / cells_wide;
+            for (int i = cell_start[cell]; i < cell_start[cell + 1]; i++) {
+                for (int j = i + 1; j < cell_start[cell + 1]; j++)
+                    add_candidate(items[i], items[j]);
+
+                for (const ivec2& offset : FORWARD) {
+                    int nx = cx + offset.x, ny = cy + offset.y;
+                    if (nx < 0 || nx >= cells_wide || ny >= cells_high)
+                        continue;
+                    int neighbour = ny * cells_wide + nx;
+                    for (int j = cell_start[neighbour]; j < cell_start[neighbour + 1]; j++)
+                        add_candidate(items[i], items[j]);
+                }
 
-	
+                // against the static layer, read only
+                const int a = items[i];
+                const float extent = max(body_half_extents[a].x, body_half_extents[a].y) + body_radii[a];
+                static_layer.query(body_positions[a], extent, [&](int s) {
+                    if (static_layer.layers[s] != body_layers[a])
+                        static_candidates.push_back({ a, s });
+                });
+            }
+        }
+
+        narrowphase(candidates, body_positions, body_half_extents, body_radii,
+                    body_positions, body_half_extents, body_radii, out);
+        narrowphase(static_candidates, body_positions, body_half_extents, body_radii,
+                    static_layer.positions, static_layer.half_extents, static_layer.radii, static_out);
+    });
+
+    // deterministic merge
+    for (const auto& buffer : worker_contacts) {
+        for (const auto& [lo, hi] : buffer)
+            registry.contacts.push(body_entities[lo], body_entities[hi], layer_pair(body_layers[lo], body_layers[hi]));
+    }
+    for (const auto& buffer : worker_static_contacts) {
+        for (const auto& [a, s] : buffer) {
+            const COLLISION_LAYER layer_a = body_layers[a];
+            const COLLISION_LAYER layer_s = static_layer.layers[s];
+            if (layer_a < layer_s)
+                registry.contacts.push(body_entities[a], static_layer.entities[s], layer_pair(layer_a, layer_s));
+            else
+                registry.contacts.push(static_layer.entities[s], body_entities[a], layer_pair(layer_a, layer_s));
+        }
+    }
+    registry.contacts.sort();
+}
@@ -4,6 +4,9 @@
 #include "tinyECS/tiny_ecs.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
+#include "spatial_grid.hpp"
+#include "worker_pool.hpp"
+#include <utility>
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
@@ -11,6 +14,8 @@ class PhysicsSystem
 public:
 	
 	// void init(WorldSystem* world);
+	// the pool is shared with the AI system, the two never run at the same time
+	void init(WorkerPool* pool) { workers = pool; }
 	void physics_step(float elapsed_ms);
 
 	PhysicsSystem()
@@ -18,5 +23,30 @@ public:
 	}
 private:
 	// WorldSystem* world_system = nullptr;
-	
+
+	void steer_invaders();
+	void separate_crowd();
+	void keep_on_lanes();
+	void detect_collisions();
+
+	// crowd pass scratch, kept between frames to avoid reallocating
+	SpatialGrid crowd_grid;
+	std::vector<vec2> crowd_positions;
+	std::vector<vec2> crowd_velocities;
+
+	// collision detection: bodies in SoA form, bucketed into a grid whose cells are
+	// narrowphased in parallel, each worker writing its own candidate and contact lists
+	WorkerPool* workers = nullptr;
+	SpatialGrid body_grid;
+	std::vector<Entity> body_entities;
+	std::vector<unsigned int> body_ids;
+	std::vector<COLLISION_LAYER> body_layers;
+	std::vector<vec2> body_positions;
+	std::vector<vec2> body_half_extents;	// zero for circles
+	std::vector<float> body_radii;			// zero for boxes
+	std::vector<std::vector<std::pair<int, int>>> worker_candidates;
+	std::vector<std::vector<std::pair<int, int>>> worker_contacts;	// body index pairs, lower layer first
+	std::vector<std::vector<std::pair<int, int>>> worker_static_candidates;
+	std::vector<std::vector<std::pair<int, int>>> worker_static_contacts;	// (body index, static layer index)
+
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+// internal
+#include "projectile_pool.hpp"
+
+#include <algorithm>
+
+ProjectilePool projectile_pool;
+
+ProjectilePool::ProjectilePool() :
+	entities(MAX_PROJECTILES),	// reserves MAX_PROJECTILES consecutive entity ids
+	motions(MAX_PROJECTILES),
+	projectiles(MAX_PROJECTILES),
+	colliders(MAX_PROJECTILES, Collider{ COLLIDER_SHAPE::CIRCLE }),
+	active(MAX_PROJECTILES, 0)
+{
+	first_id = entities.front().id();
+	clear();
+}
+
+bool ProjectilePool::spawn(vec2 position, vec2 size, vec2 velocity, int damage)
+{
+	if (free_slots.empty()) {
+		dropped++;
+		return false;
+	}
+
+	int slot = free_slots.back();
+	free_slots.pop_back();
+
+	Motion& motion = motions[slot];
+	motion.position = position;
+	motion.angle = 0.f;
+	motion.velocity = velocity;
+	motion.scale = size;
+	projectiles[slot].damage = damage;
+	colliders[slot].radius = min(size.x, size.y) / 2.f;
+	active[slot] = 1;
+
+	peak_active = std::max(peak_active, active_count());
+	return true;
+}
+
+void ProjectilePool::release(int slot)
+{
+	if (!active[slot])
+		return;
+	active[slot] = 0;
+	free_slots.push_back(slot);
+}
+
+void ProjectilePool::clear()
+{
+	std::fill(active.begin(), active.end(), 0);
+
+	// hand out low slots first so live projectiles stay packed at the front
+	free_slots.clear();
+	for (int slot = (int)capacity() - 1; slot >= 0; slot--)
+		free_slots.push_back(slot);
+}
+
+int ProjectilePool::slot_of(Entity entity) const
+{
+	unsigned int id = entity.id();
+	if (id < first_id || id >= first_id + capacity())
+		return -1;
+	return (int)(id - first_id);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+#include <vector>
+
+// Fixed-capacity storage for projectiles.
+// Every slot owns an entity id for the whole game and dormant slots keep their
+// storage, so firing reactivates a slot in place and a hit or leaving the screen
+// just returns it to the free list; no registry inserts, removals or new ids.
+class ProjectilePool
+{
+public:
+	ProjectilePool();
+
+	// activate a dormant projectile, returns false when every slot is in use
+	bool spawn(vec2 position, vec2 size, vec2 velocity, int damage);
+
+	// return a live projectile to the pool
+	void release(int slot);
+
+	// retire all projectiles, e.g. on restart
+	void clear();
+
+	// slot of a pooled projectile entity, -1 for any other entity
+	int slot_of(Entity entity) const;
+
+	bool is_active(int slot) const { return active[slot] != 0; }
+	size_t capacity() const { return active.size(); }
+	size_t active_count() const { return capacity() - free_slots.size(); }
+
+	// pool pressure, reported in the window title
+	size_t peak_active = 0;
+	size_t dropped = 0;	// shots refused because the pool was exhausted
+
+	// contiguous per-slot storage, only slots with active[i] set are live
+	std::vector<Entity> entities;
+	std::vector<Motion> motions;
+	std::vector<Projectile> projectiles;
+	std::vector<Collider> colliders;
+	std::vector<uint8_t> active;
+
+private:
+	std::vector<int> free_slots;	// stack of dormant slots
+	unsigned int first_id;
+};
+
+extern ProjectilePool projectile_pool;
@@ -6,6 +6,7 @@
 // internal
 #include "render_system.hpp"
 #include "tinyECS/registry.hpp"
+#include "projectile_pool.hpp"
 
 void RenderSystem::drawGridLine(Entity entity,
 								const mat3& projection) {
@@ -97,7 +98,17 @@ void RenderSystem::drawGridLine(Entity entity,
 void RenderSystem::drawTexturedMesh(Entity entity,
 									const mat3 &projection)
 {
-	Motion &motion = registry.motions.get(entity);
+	assert(registry.renderRequests.has(entity));
+	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
+	drawTexturedMesh(registry.motions.get(entity), registry.renderRequests.get(entity), color, projection);
+}
+
+// draws from the components directly, also used for pooled entities that are not in the registry
+void RenderSystem::drawTexturedMesh(const Motion &motion,
+									const RenderRequest &render_request,
+									const vec3 &color,
+									const mat3 &projection)
+{
 	// Transformation code, see Rendering and Transformation in the template
 	// specification for more info Incrementally updates transformation matrix,
 	// thus ORDER IS IMPORTANT
@@ -106,9 +117,6 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 	transform.scale(motion.scale);
 	transform.rotate(radians(motion.angle));
 
-	assert(registry.renderRequests.has(entity));
-	const RenderRequest &render_request = registry.renderRequests.get(entity);
-
 	const GLuint used_effect_enum = (GLuint)render_request.used_effect;
 	assert(used_effect_enum != (GLuint)EFFECT_ASSET_ID::EFFECT_COUNT);
 	const GLuint program = (GLuint)effects[used_effect_enum];
@@ -149,9 +157,8 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 		glActiveTexture(GL_TEXTURE0);
 		gl_has_errors();
 
-		assert(registry.renderRequests.has(entity));
 		GLuint texture_id =
-			texture_gl_handles[(GLuint)registry.renderRequests.get(entity).used_texture];
+			texture_gl_handles[(GLuint)render_request.used_texture];
 
 		glBindTexture(GL_TEXTURE_2D, texture_id);
 		gl_has_errors();
@@ -180,7 +187,6 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 
 	// Getting uniform locations for glUniform* calls
 	GLint color_uloc = glGetUniformLocation(program, "fcolor");
-	const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
 	glUniform3fv(color_uloc, 1, (float *)&color);
 	gl_has_errors();
 
@@ -327,6 +333,16 @@ void RenderSystem::draw(GAME_SCREEN_ID game_screen)
 	gl_has_errors();
 
 	mat3 projection_2D = createProjectionMatrix();
+	mat3 map_projection = createProjectionMatrix(camera);
+
+	// skip map entities outside the window, the map can be far larger
+	const vec2 view_lo = camera;
+	const vec2 view_hi = camera + vec2(WINDOW_WIDTH_PX, WINDOW_HEIGHT_PX);
+	auto in_view = [&](const Motion& motion) {
+		float reach = max(abs(motion.scale.x), abs(motion.scale.y)) / 2.f;
+		return motion.position.x + reach >= view_lo.x && motion.position.x - reach <= view_hi.x
+			&& motion.position.y + reach >= view_lo.y && motion.position.y - reach <= view_hi.y;
+	};
 
 	// A2: draw gridlines first
 	for (auto entity : registry.gridLines.entities) {
@@ -339,7 +355,7 @@ void RenderSystem::draw(GAME_SCREEN_ID game_screen)
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	// draw any filledTiles here so they appear behind the main, but above the grid lines
 	for (Entity entity : registry.filledTiles.entities) {
-		drawFilledTile(entity, projection_2D);
+		drawFilledTile(entity, map_projection);
 	}
 
 	// A2: draw everything else over top of the previous items
@@ -353,8 +369,9 @@ void RenderSystem::draw(GAME_SCREEN_ID game_screen)
 		if ((game_screen == GAME_SCREEN_ID::DRAWING
 			|| game_screen == GAME_SCREEN_ID::PLAYING)
 			&& registry.motions.has(entity)
-			&& !registry.selectables.has(entity)) {
-			drawTexturedMesh(entity, projection_2D);
+			&& !registry.selectables.has(entity)
+			&& in_view(registry.motions.get(entity))) {
+			drawTexturedMesh(entity, map_projection);
 		}
 
 		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -366,6 +383,19 @@ void RenderSystem::draw(GAME_SCREEN_ID game_screen)
 		}
 	}
 
+	// projectiles are pooled outside the registry, draw the live ones over the map
+	if (game_screen == GAME_SCREEN_ID::DRAWING || game_screen == GAME_SCREEN_ID::PLAYING) {
+		static const RenderRequest projectile_request = {
+			TEXTURE_ASSET_ID::PROJECTILE,
+			EFFECT_ASSET_ID::TEXTURED,
+			GEOMETRY_BUFFER_ID::SPRITE
+		};
+		for (size_t slot = 0; slot < projectile_pool.capacity(); slot++) {
+			if (projectile_pool.is_active((int)slot) && in_view(projectile_pool.motions[slot]))
+				drawTexturedMesh(projectile_pool.motions[slot], projectile_request, vec3(1), map_projection);
+		}
+	}
+
 	// draw framebuffer to screen
 	// adding "vignette" effect when applied
 	drawToScreen();
@@ -408,13 +438,13 @@ void RenderSystem::draw(GAME_SCREEN_ID game_screen)
 	gl_has_errors();
 }
 
-mat3 RenderSystem::createProjectionMatrix()
+mat3 RenderSystem::createProjectionMatrix(vec2 top_left)
 {
 	// fake projection matrix, scaled to window coordinates
-	float left   = 0.f;
-	float top    = 0.f;
-	float right  = (float) WINDOW_WIDTH_PX;
-	float bottom = (float) WINDOW_HEIGHT_PX;
+	float left   = top_left.x;
+	float top    = top_left.y;
+	float right  = top_left.x + (float) WINDOW_WIDTH_PX;
+	float bottom = top_left.y + (float) WINDOW_HEIGHT_PX;
 
 	float sx = 2.f / (right - left);
 	float sy = 2.f / (top - bottom);
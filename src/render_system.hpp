@@ -92,7 +92,14 @@ class RenderSystem {
 		textures_path("invaders/green_1.png"),
 		textures_path("effects/explosion1.png"),
 		textures_path("effects/explosion2.png"),
-		textures_path("effects/explosion3.png")
+		textures_path("effects/explosion3.png"),
+
+		textures_path("towers/tower02.png"),
+		textures_path("towers/tower03.png"),
+		textures_path("towers/tower04.png"),
+		textures_path("towers/tower05.png"),
+		textures_path("towers/tower06.png"),
+		textures_path("towers/tower07.png")
 	};
 
 	std::array<GLuint, effect_count> effects;
@@ -142,7 +149,12 @@ public:
 	// Draw all entities - (A2) based on the game_screen
 	void draw(GAME_SCREEN_ID game_screen);
 
-	mat3 createProjectionMatrix();
+	// window coordinates, shifted so that top_left is the window's top left corner
+	mat3 createProjectionMatrix(vec2 top_left = vec2(0.f));
+
+	// A2: top left of the window in map pixels, the world scrolls under it while the
+	//     grid lines, text and tile selector stay in screen space
+	vec2 camera = { 0.f, 0.f };
 
 	void drawFilledTile(Entity entity, const mat3& projection);
 
@@ -158,6 +170,7 @@ private:
 	// Internal drawing functions for each entity type
 	
 	void drawTexturedMesh(Entity entity, const mat3& projection);
+	void drawTexturedMesh(const Motion& motion, const RenderRequest& render_request, const vec3& color, const mat3& projection);
 	void drawToScreen();
 
 	// Window handle
@@ -0,0 +1,56 @@
+// internal
+#include "spatial_grid.hpp"
+
+void SpatialGrid::build(const std::vector<vec2>& points, float cell_size_px)
+{
+	vec2 lo = points.empty() ? vec2(0.f) : points[0];
+	vec2 hi = lo;
+	for (const vec2& p : points) {
+		lo = min(lo, p);
+		hi = max(hi, p);
+	}
+
+	// cells aligned to multiples of the cell size over the bounding box, doubled in size
+	// while that would be more cells than the points warrant
+	const size_t max_cells = SPATIAL_GRID_CELLS_PER_POINT * points.size() + SPATIAL_GRID_MIN_CELLS;
+	cell_size = cell_size_px;
+	for (;;) {
+		origin = ivec2(floor(lo / cell_size));
+		const ivec2 last = ivec2(floor(hi / cell_size));
+		cells_wide = last.x - origin.x + 1;
+		cells_high = last.y - origin.y + 1;
+		if ((size_t)cells_wide * cells_high <= max_cells)
+			break;
+		cell_size *= 2.f;
+	}
+
+	// counting sort: histogram, prefix sum, scatter
+	cell_start.assign(cells_wide * cells_high + 1, 0);
+	point_cell.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++) {
+		ivec2 c = cell_of(points[i]);
+		point_cell[i] = c.y * cells_wide + c.x;
+		cell_start[point_cell[i] + 1]++;
+	}
+	for (size_t c = 1; c < cell_start.size(); c++)
+		cell_start[c] += cell_start[c - 1];
+
+	// scatter in point order, so each cell lists its points by increasing index
+	items.resize(points.size());
+	fill.assign(cell_start.begin(), cell_start.end() - 1);
+	for (size_t i = 0; i < points.size(); i++)
+		items[fill[point_cell[i]]++] = (int)i;
+
+	occupied.clear();
+	for (int c = 0; c < cells_wide * cells_high; c++) {
+		if (cell_start[c + 1] > cell_start[c])
+			occupied.push_back(c);
+	}
+}
+
+ivec2 SpatialGrid::cell_of(vec2 p) const
+{
+	int cx = (int)floor(p.x / cell_size) - origin.x;
+	int cy = (int)floor(p.y / cell_size) - origin.y;
+	return { clamp(cx, 0, cells_wide - 1), clamp(cy, 0, cells_high - 1) };
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.hpp"
+#include <vector>
+
+// A uniform grid over a set of points, rebuilt from scratch every frame with a
+// counting sort. Point indices are stored contiguously per cell so a neighbour
+// query only touches the few cells that overlap the query circle.
+// The grid only spans the bounding box of the points, not the map, and when the points are
+// spread thin the cells are coarsened until there are at most a few per point, so a build
+// costs O(points) however large the map is. Queries reaching past the box are clamped to
+// its border cells.
+class SpatialGrid
+{
+public:
+	// bucket the points into cells of cell_size x cell_size pixels
+	void build(const std::vector<vec2>& points, float cell_size);
+
+	ivec2 cell_of(vec2 p) const;
+
+	// calls visit(point_index) for every point in the cells overlapping the circle,
+	// stops early when visit returns false. Callers do their own exact distance test.
+	template <class Visitor>
+	void query(vec2 center, float radius, Visitor&& visit) const
+	{
+		ivec2 lo = cell_of(center - vec2(radius));
+		ivec2 hi = cell_of(center + vec2(radius));
+		for (int cy = lo.y; cy <= hi.y; cy++) {
+			for (int cx = lo.x; cx <= hi.x; cx++) {
+				int cell = cy * cells_wide + cx;
+				for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++) {
+					if (!visit(items[k]))
+						return;
+				}
+			}
+		}
+	}
+
+	// calls visit(first, last) with the item range of every cell overlapping the circle,
+	// for callers that keep each cell's items in a meaningful order
+	template <class Visitor>
+	void for_each_cell(vec2 center, float radius, Visitor&& visit) const
+	{
+		ivec2 lo = cell_of(center - vec2(radius));
+		ivec2 hi = cell_of(center + vec2(radius));
+		for (int cy = lo.y; cy <= hi.y; cy++) {
+			for (int cx = lo.x; cx <= hi.x; cx++) {
+				int cell = cy * cells_wide + cx;
+				visit(items.data() + cell_start[cell], items.data() + cell_start[cell + 1]);
+			}
+		}
+	}
+
+	int cells_wide = 0;
+	int cells_high = 0;
+	float cell_size = 1.f;			// at least the size asked for, larger if coarsened
+	ivec2 origin = { 0, 0 };		// position of cell 0 in multiples of cell_size
+
+	std::vector<int> cell_start;	// items of cell c are items[cell_start[c] .. cell_start[c + 1])
+	std::vector<int> items;			// point indices, sorted by cell
+	std::vector<int> occupied;		// cells holding at least one point, in increasing order
+
+private:
+	// scratch, kept between builds to avoid reallocating
+	std::vector<int> point_cell;
+	std::vector<int> fill;
+};
@@ -0,0 +1,62 @@
+// internal
+#include "static_layer.hpp"
+#include "tinyECS/registry.hpp"
+
+StaticLayer static_layer;
+
+void StaticLayer::build()
+{
+	const int num_cells = map_grid.count();
+
+	// collect the static colliders with their clamped cell; towers are the only
+	// static bodies with a collision handler
+	std::vector<int> body_cell;
+	std::vector<Entity> bodies;
+	for (Entity entity : registry.staticBodies.entities) {
+		if (!registry.towers.has(entity) || !registry.colliders.has(entity))
+			continue;
+		const vec2 position = registry.motions.get(entity).position;
+		int cx = clamp((int)(position.x / GRID_CELL_WIDTH_PX), 0, map_grid.wide - 1);
+		int cy = clamp((int)(position.y / GRID_CELL_HEIGHT_PX), 0, map_grid.high - 1);
+		body_cell.push_back(cy * map_grid.wide + cx);
+		bodies.push_back(entity);
+	}
+
+	// counting sort by cell
+	cell_start.assign(num_cells + 1, 0);
+	for (int cell : body_cell)
+		cell_start[cell + 1]++;
+	for (int c = 0; c < num_cells; c++)
+		cell_start[c + 1] += cell_start[c];
+
+	std::vector<int> order(bodies.size());
+	std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+	for (size_t i = 0; i < bodies.size(); i++)
+		order[fill[body_cell[i]]++] = (int)i;
+
+	entities.clear();
+	layers.clear();
+	positions.clear();
+	half_extents.clear();
+	radii.clear();
+	max_extent = 0.f;
+	for (int i : order) {
+		Entity entity = bodies[i];
+		const Collider& collider = registry.colliders.get(entity);
+		entities.push_back(entity);
+		layers.push_back(COLLISION_LAYER::TOWER);
+		positions.push_back(registry.motions.get(entity).position);
+		if (collider.shape == COLLIDER_SHAPE::CIRCLE) {
+			half_extents.push_back({ 0, 0 });
+			radii.push_back(collider.radius);
+			max_extent = max(max_extent, collider.radius);
+		}
+		else {
+			half_extents.push_back(collider.half_extents);
+			radii.push_back(0.f);
+			max_extent = max(max_extent, max(collider.half_extents.x, collider.half_extents.y));
+		}
+	}
+
+	built = true;
+}
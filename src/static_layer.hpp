@@ -0,0 +1,54 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+#include <vector>
+
+// The collision layer of static bodies (entities tagged StaticBody: level tiles and towers).
+// They never move, so instead of going through the per-frame broadphase with everything
+// else they are bucketed once per tile cell and only rebuilt after the map or the towers
+// change. Between rebuilds the physics system only reads it, from any thread.
+// Tiles are static but have nothing to collide with, so only towers end up in the cells.
+class StaticLayer
+{
+public:
+	// bucket every static body with a collider by the tile cell of its center
+	void build();
+
+	// mark the layer stale after a map or tower change, rebuilt on the next physics step
+	void invalidate() { built = false; }
+	bool ready() const { return built; }
+
+	// calls visit(static_index) for every static body whose center cell could hold a body
+	// overlapping the box center +- extent; callers do the exact test
+	template <class Visitor>
+	void query(vec2 center, float extent, Visitor&& visit) const
+	{
+		const float reach = extent + max_extent;
+		const int x0 = max((int)floor((center.x - reach) / GRID_CELL_WIDTH_PX), 0);
+		const int y0 = max((int)floor((center.y - reach) / GRID_CELL_HEIGHT_PX), 0);
+		const int x1 = min((int)floor((center.x + reach) / GRID_CELL_WIDTH_PX), map_grid.wide - 1);
+		const int y1 = min((int)floor((center.y + reach) / GRID_CELL_HEIGHT_PX), map_grid.high - 1);
+		for (int cy = y0; cy <= y1; cy++) {
+			for (int cx = x0; cx <= x1; cx++) {
+				int cell = cy * map_grid.wide + cx;
+				for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++)
+					visit(k);
+			}
+		}
+	}
+
+	// static bodies sorted by cell, SoA like the physics system's dynamic bodies
+	std::vector<Entity> entities;
+	std::vector<COLLISION_LAYER> layers;
+	std::vector<vec2> positions;
+	std::vector<vec2> half_extents;	// zero for circles
+	std::vector<float> radii;		// zero for boxes
+
+private:
+	bool built = false;
+	float max_extent = 0.f;
+	std::vector<int> cell_start;	// bodies of cell c are [cell_start[c], cell_start[c + 1])
+};
+
+extern StaticLayer static_layer;
@@ -0,0 +1,84 @@
+// internal
+#include "tile_grid.hpp"
+#include "tiles.hpp"
+
+#include <algorithm>
+
+TileGrid tile_grid;
+
+TileGrid::TileGrid()
+{
+	clear();
+}
+
+void TileGrid::add(Entity entity, const Tile& tile)
+{
+	ivec2 cell = { tile.tx, tile.ty };
+	if (!in_bounds(cell))
+		return;
+
+	remove(cell);
+	const int i = index(cell);
+	slots[i] = (int)entities.size();
+	ids[i] = tile.tile_id;
+	entities.push_back(entity);
+	entity_cells.push_back(i);
+
+	if (is_start_tile(tile.tile_id))
+		start_cells.push_back(i);
+	if (is_exit_tile(tile.tile_id))
+		exit_cells.push_back(i);
+}
+
+bool TileGrid::remove(ivec2 cell)
+{
+	if (!has(cell))
+		return false;
+
+	// swap the last registered tile into the freed slot
+	const int i = index(cell);
+	const int slot = slots[i];
+	entities[slot] = entities.back();
+	entity_cells[slot] = entity_cells.back();
+	slots[entity_cells[slot]] = slot;
+	entities.pop_back();
+	entity_cells.pop_back();
+	slots[i] = -1;
+
+	// a handful of entries at most, keep them in placement order
+	start_cells.erase(std::remove(start_cells.begin(), start_cells.end(), i), start_cells.end());
+	exit_cells.erase(std::remove(exit_cells.begin(), exit_cells.end(), i), exit_cells.end());
+	return true;
+}
+
+void TileGrid::clear()
+{
+	const int num_cells = map_grid.count();
+	slots.assign(num_cells, -1);
+	ids.assign(num_cells, TEXTURE_ASSET_ID::TEXTURE_COUNT);
+	entities.clear();
+	entity_cells.clear();
+	start_cells.clear();
+	exit_cells.clear();
+}
+
+bool TileGrid::in_bounds(ivec2 cell) const
+{
+	return map_grid.in_bounds(cell);
+}
+
+bool TileGrid::first_start(ivec2& cell) const
+{
+	if (start_cells.empty())
+		return false;
+	cell = cell_of(start_cells.front());
+	return true;
+}
+
+bool TileGrid::first_exit(ivec2& cell) const
+{
+	if (exit_cells.empty())
+		return false;
+	cell = cell_of(exit_cells.front());
+	return true;
+}
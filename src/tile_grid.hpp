@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+#include <vector>
+
+// Dense per-cell index of the level tiles, so finding the tile in a cell is an array
+// lookup instead of a scan over registry.tiles.
+// Level tiles register when they are created and unregister when removed; tile-selector
+// tiles are not part of the level and never enter the grid. Anything that wipes the
+// level tiles wholesale (restart, level load, back to the intro) clears it as well.
+class TileGrid
+{
+public:
+	TileGrid();
+
+	// register a level tile in its cell, replacing whatever the cell held before
+	void add(Entity entity, const Tile& tile);
+
+	// unregister the tile in a cell, returns false if the cell was empty
+	bool remove(ivec2 cell);
+
+	// forget every tile and resize to the current map_grid, e.g. after all of them were
+	// removed from the registry or a level with another size is loaded
+	void clear();
+
+	bool in_bounds(ivec2 cell) const;
+	bool has(ivec2 cell) const { return in_bounds(cell) && slots[index(cell)] >= 0; }
+
+	// only valid where has(cell)
+	Entity entity_at(ivec2 cell) const { return entities[slots[index(cell)]]; }
+	TEXTURE_ASSET_ID tile_id_at(ivec2 cell) const { return ids[index(cell)]; }
+
+	// earliest placed start / exit tile still on the map
+	bool first_start(ivec2& cell) const;
+	bool first_exit(ivec2& cell) const;
+
+	// every start tile, in placement order
+	size_t start_count() const { return start_cells.size(); }
+	ivec2 start_at(size_t k) const { return cell_of(start_cells[k]); }
+
+private:
+	int index(ivec2 cell) const { return map_grid.index(cell); }
+	ivec2 cell_of(int i) const { return map_grid.cell_of(i); }
+
+	std::vector<int> slots;					// per cell, index into entities or -1
+	std::vector<TEXTURE_ASSET_ID> ids;		// per cell, valid where the slot is set
+
+	// registered tiles (unordered) and the cell each one sits in
+	std::vector<Entity> entities;
+	std::vector<int> entity_cells;
+
+	// start and exit cells in placement order
+	std::vector<int> start_cells;
+	std::vector<int> exit_cells;
+};
+
+extern TileGrid tile_grid;
@@ -1,109 +1,104 @@
-#include <map>
-#include "tinyECS/components.hpp"
+#pragma once
 
-// A2: new file that holds tile details for pathing (tile_dir)
+#include <array>
+#include <cstdint>
+#include "tinyECS/components.hpp"
 
-// NOTE: this must be _manually_ aligned to components
-// top (0), right (1), bottom (2), left(3)
-struct tile_dir {
-    bool top;
-    bool right;
-    bool bottom;
-    bool left;
+// A2: new file that holds tile details for pathing
 
-    tile_dir() { top = false; right = false; bottom = false; left = false; }
-    tile_dir(bool t, bool r, bool b, bool l) : top(t), right(r), bottom(b), left(l) {}
-};
+// One byte per texture: the sides a path can leave the tile through, one bit per
+// direction top (0), right (1), bottom (2), left (3), plus whether it is a start or
+// an exit tile. Textures that are not map tiles have no bits set.
+constexpr uint8_t TILE_TOP = 1 << 0;
+constexpr uint8_t TILE_RIGHT = 1 << 1;
+constexpr uint8_t TILE_BOTTOM = 1 << 2;
+constexpr uint8_t TILE_LEFT = 1 << 3;
+constexpr uint8_t TILE_SIDES = TILE_TOP | TILE_RIGHT | TILE_BOTTOM | TILE_LEFT;
+constexpr uint8_t TILE_START = 1 << 4;
+constexpr uint8_t TILE_EXIT = 1 << 5;
 
-static inline std::map<TEXTURE_ASSET_ID, tile_dir>
-TILE_DIRECTIONS = {
+// NOTE: this must be _manually_ aligned to components, MAPTILE_121 .. MAPTILE_281 in enum order
+constexpr uint8_t MAP_TILE_BITS[] = {
 
     /* regular tiles */
-    {TEXTURE_ASSET_ID::MAPTILE_121, tile_dir(false, true,  true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_122, tile_dir(false, false, true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_123, tile_dir(true,  true,  false, false)},
-    {TEXTURE_ASSET_ID::MAPTILE_124, tile_dir(true,  false, false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_125, tile_dir(false, true,  true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_126, tile_dir(true,  false, true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_127, tile_dir(false, true,  false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_128, tile_dir(true,  true,  true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_129, tile_dir(false, false, true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_130, tile_dir(false, false, false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_142, tile_dir(true,  true,  false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_143, tile_dir(true,  true,  true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_144, tile_dir(true,  false, true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_146, tile_dir(true,  false, false, false)},
-    {TEXTURE_ASSET_ID::MAPTILE_147, tile_dir(false, true,  false, false)},
+    TILE_RIGHT | TILE_BOTTOM,                           // MAPTILE_121
+    TILE_BOTTOM | TILE_LEFT,                            // MAPTILE_122
+    TILE_TOP | TILE_RIGHT,                              // MAPTILE_123
+    TILE_TOP | TILE_LEFT,                               // MAPTILE_124
+    TILE_RIGHT | TILE_BOTTOM | TILE_LEFT,               // MAPTILE_125
+    TILE_TOP | TILE_BOTTOM,                             // MAPTILE_126
+    TILE_RIGHT | TILE_LEFT,                             // MAPTILE_127
+    TILE_SIDES,                                         // MAPTILE_128
+    TILE_BOTTOM,                                        // MAPTILE_129
+    TILE_LEFT,                                          // MAPTILE_130
+    TILE_TOP | TILE_RIGHT | TILE_LEFT,                  // MAPTILE_142
+    TILE_TOP | TILE_RIGHT | TILE_BOTTOM,                // MAPTILE_143
+    TILE_TOP | TILE_BOTTOM | TILE_LEFT,                 // MAPTILE_144
+    TILE_TOP,                                           // MAPTILE_146
+    TILE_RIGHT,                                         // MAPTILE_147
 
     /* start tiles */
-    {TEXTURE_ASSET_ID::MAPTILE_155, tile_dir(false, true,  true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_156, tile_dir(false, false, true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_159, tile_dir(false, true,  true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_160, tile_dir(true,  false, true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_161, tile_dir(false, true,  false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_162, tile_dir(true,  true,  true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_163, tile_dir(false, false, true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_164, tile_dir(false, false, false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_172, tile_dir(true,  true,  false, false)},
-    {TEXTURE_ASSET_ID::MAPTILE_173, tile_dir(true,  false, false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_176, tile_dir(true,  true,  false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_177, tile_dir(true,  true,  true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_178, tile_dir(true,  false, true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_180, tile_dir(true,  false, false, false)},
-    {TEXTURE_ASSET_ID::MAPTILE_181, tile_dir(false, true,  false, false)},
+    TILE_START | TILE_RIGHT | TILE_BOTTOM,              // MAPTILE_155
+    TILE_START | TILE_BOTTOM | TILE_LEFT,               // MAPTILE_156
+    TILE_START | TILE_RIGHT | TILE_BOTTOM | TILE_LEFT,  // MAPTILE_159
+    TILE_START | TILE_TOP | TILE_BOTTOM,                // MAPTILE_160
+    TILE_START | TILE_RIGHT | TILE_LEFT,                // MAPTILE_161
+    TILE_START | TILE_SIDES,                            // MAPTILE_162
+    TILE_START | TILE_BOTTOM,                           // MAPTILE_163
+    TILE_START | TILE_LEFT,                             // MAPTILE_164
+    TILE_START | TILE_TOP | TILE_RIGHT,                 // MAPTILE_172
+    TILE_START | TILE_TOP | TILE_LEFT,                  // MAPTILE_173
+    TILE_START | TILE_TOP | TILE_RIGHT | TILE_LEFT,     // MAPTILE_176
+    TILE_START | TILE_TOP | TILE_RIGHT | TILE_BOTTOM,   // MAPTILE_177
+    TILE_START | TILE_TOP | TILE_BOTTOM | TILE_LEFT,    // MAPTILE_178
+    TILE_START | TILE_TOP,                              // MAPTILE_180
+    TILE_START | TILE_RIGHT,                            // MAPTILE_181
 
     /* exit tiles */
-    {TEXTURE_ASSET_ID::MAPTILE_255, tile_dir(false, true,  true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_256, tile_dir(false, false, true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_259, tile_dir(false, true,  true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_260, tile_dir(true,  false, true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_261, tile_dir(false, true,  false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_262, tile_dir(true,  true,  true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_263, tile_dir(false, false, true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_264, tile_dir(false, false, false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_272, tile_dir(true,  true,  false, false)},
-    {TEXTURE_ASSET_ID::MAPTILE_273, tile_dir(true,  false, false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_276, tile_dir(true,  true,  false, true )},
-    {TEXTURE_ASSET_ID::MAPTILE_277, tile_dir(true,  true,  true,  false)},
-    {TEXTURE_ASSET_ID::MAPTILE_278, tile_dir(true,  false, true,  true )},
-    {TEXTURE_ASSET_ID::MAPTILE_280, tile_dir(true,  false, false, false)},
-    {TEXTURE_ASSET_ID::MAPTILE_281, tile_dir(false, true,  false, false)}
+    TILE_EXIT | TILE_RIGHT | TILE_BOTTOM,               // MAPTILE_255
+    TILE_EXIT | TILE_BOTTOM | TILE_LEFT,                // MAPTILE_256
+    TILE_EXIT | TILE_RIGHT | TILE_BOTTOM | TILE_LEFT,   // MAPTILE_259
+    TILE_EXIT | TILE_TOP | TILE_BOTTOM,                 // MAPTILE_260
+    TILE_EXIT | TILE_RIGHT | TILE_LEFT,                 // MAPTILE_261
+    TILE_EXIT | TILE_SIDES,                             // MAPTILE_262
+    TILE_EXIT | TILE_BOTTOM,                            // MAPTILE_263
+    TILE_EXIT | TILE_LEFT,                              // MAPTILE_264
+    TILE_EXIT | TILE_TOP | TILE_RIGHT,                  // MAPTILE_272
+    TILE_EXIT | TILE_TOP | TILE_LEFT,                   // MAPTILE_273
+    TILE_EXIT | TILE_TOP | TILE_RIGHT | TILE_LEFT,      // MAPTILE_276
+    TILE_EXIT | TILE_TOP | TILE_RIGHT | TILE_BOTTOM,    // MAPTILE_277
+    TILE_EXIT | TILE_TOP | TILE_BOTTOM | TILE_LEFT,     // MAPTILE_278
+    TILE_EXIT | TILE_TOP,                               // MAPTILE_280
+    TILE_EXIT | TILE_RIGHT                              // MAPTILE_281
 };
 
-static inline std::map<TEXTURE_ASSET_ID, bool>
-START_TILES = {
-    {TEXTURE_ASSET_ID::MAPTILE_155, true},
-    {TEXTURE_ASSET_ID::MAPTILE_156, true},
-    {TEXTURE_ASSET_ID::MAPTILE_159, true},
-    {TEXTURE_ASSET_ID::MAPTILE_160, true},
-    {TEXTURE_ASSET_ID::MAPTILE_161, true},
-    {TEXTURE_ASSET_ID::MAPTILE_162, true},
-    {TEXTURE_ASSET_ID::MAPTILE_163, true},
-    {TEXTURE_ASSET_ID::MAPTILE_164, true},
-    {TEXTURE_ASSET_ID::MAPTILE_172, true},
-    {TEXTURE_ASSET_ID::MAPTILE_173, true},
-    {TEXTURE_ASSET_ID::MAPTILE_176, true},
-    {TEXTURE_ASSET_ID::MAPTILE_177, true},
-    {TEXTURE_ASSET_ID::MAPTILE_178, true},
-    {TEXTURE_ASSET_ID::MAPTILE_180, true},
-    {TEXTURE_ASSET_ID::MAPTILE_181, true}
-};
+static_assert(sizeof(MAP_TILE_BITS) == (int)TEXTURE_ASSET_ID::MAPTILE_281 - (int)TEXTURE_ASSET_ID::MAPTILE_121 + 1,
+    "MAP_TILE_BITS needs one entry per map tile in TEXTURE_ASSET_ID");
 
-static inline std::map<TEXTURE_ASSET_ID, bool>
-EXIT_TILES = {
-    {TEXTURE_ASSET_ID::MAPTILE_255, true},
-    {TEXTURE_ASSET_ID::MAPTILE_256, true},
-    {TEXTURE_ASSET_ID::MAPTILE_259, true},
-    {TEXTURE_ASSET_ID::MAPTILE_260, true},
-    {TEXTURE_ASSET_ID::MAPTILE_261, true},
-    {TEXTURE_ASSET_ID::MAPTILE_262, true},
-    {TEXTURE_ASSET_ID::MAPTILE_263, true},
-    {TEXTURE_ASSET_ID::MAPTILE_264, true},
-    {TEXTURE_ASSET_ID::MAPTILE_272, true},
-    {TEXTURE_ASSET_ID::MAPTILE_273, true},
-    {TEXTURE_ASSET_ID::MAPTILE_276, true},
-    {TEXTURE_ASSET_ID::MAPTILE_277, true},
-    {TEXTURE_ASSET_ID::MAPTILE_278, true},
-    {TEXTURE_ASSET_ID::MAPTILE_280, true},
-    {TEXTURE_ASSET_ID::MAPTILE_281, true}
-};
+// spread over the whole texture range so lookups are a plain index by tile id
+constexpr std::array<uint8_t, texture_count> make_tile_bits()
+{
+    std::array<uint8_t, texture_count> bits = {};
+    for (size_t i = 0; i < sizeof(MAP_TILE_BITS); i++)
+        bits[(size_t)TEXTURE_ASSET_ID::MAPTILE_121 + i] = MAP_TILE_BITS[i];
+    return bits;
+}
+
+constexpr std::array<uint8_t, texture_count> TILE_BITS = make_tile_bits();
+
+constexpr uint8_t tile_sides(TEXTURE_ASSET_ID id) { return TILE_BITS[(size_t)id] & TILE_SIDES; }
+constexpr bool is_start_tile(TEXTURE_ASSET_ID id) { return TILE_BITS[(size_t)id] & TILE_START; }
+constexpr bool is_exit_tile(TEXTURE_ASSET_ID id) { return TILE_BITS[(size_t)id] & TILE_EXIT; }
+
+// a path can step from one tile to the next in direction d if both open toward each other
+constexpr bool tiles_connect(TEXTURE_ASSET_ID from, TEXTURE_ASSET_ID to, uint8_t d)
+{
+    return (TILE_BITS[(size_t)from] >> d) & (TILE_BITS[(size_t)to] >> ((d + 2) % 4)) & 1;
+}
+
+// the block boundaries, where a shifted enum would show first
+static_assert(tile_sides(TEXTURE_ASSET_ID::MAPTILE_121) == (TILE_RIGHT | TILE_BOTTOM) && !is_start_tile(TEXTURE_ASSET_ID::MAPTILE_147)
+    && is_start_tile(TEXTURE_ASSET_ID::MAPTILE_155) && is_start_tile(TEXTURE_ASSET_ID::MAPTILE_181)
+    && is_exit_tile(TEXTURE_ASSET_ID::MAPTILE_255) && is_exit_tile(TEXTURE_ASSET_ID::MAPTILE_281)
+    && TILE_BITS[(size_t)TEXTURE_ASSET_ID::PROJECTILE] == 0 && TILE_BITS[(size_t)TEXTURE_ASSET_ID::INVADER_RED] == 0,
+    "TILE_BITS is out of line with TEXTURE_ASSET_ID");
@@ -25,15 +25,51 @@ struct Character {
 };
 
 // Tower
+// how a tower delivers its shots
+enum class FIRE_MODE {
+	PROJECTILE = 0,	// a pooled projectile that physics moves and collides
+	HIT_SCAN = 1	// damage scheduled for the solved time of impact, nothing is simulated
+};
+
+// which invader in range a tower picks
+enum class TARGET_POLICY {
+	CLOSEST = 0,
+	FIRST = CLOSEST + 1,		// furthest along the path
+	LAST = FIRST + 1,			// least far along the path
+	STRONGEST = LAST + 1,		// most health left
+	WEAKEST = STRONGEST + 1,	// least health left
+	POLICY_COUNT = WEAKEST + 1
+};
+
+// tower archetypes, their stats are in tower_types.hpp
+enum class TOWER_TYPE {
+	BASIC = 0,
+	RAPID = BASIC + 1,		// fast, weak shots
+	SNIPER = RAPID + 1,		// long range, slow and strong
+	SCATTER = SNIPER + 1,	// a spread of shots at once
+	HEAVY = SCATTER + 1,	// slow, heavy shots
+	FINISHER = HEAVY + 1,	// picks off the weakest
+	REARGUARD = FINISHER + 1,	// holds back the stragglers
+	TYPE_COUNT = REARGUARD + 1
+};
+
 struct Tower {
+	TOWER_TYPE type = TOWER_TYPE::BASIC;
 	float range;	// for vision / detection
 	int timer_ms;	// when to shoot - this could also be a separate timer component...
+	TARGET_POLICY targeting = TARGET_POLICY::CLOSEST;
+	FIRE_MODE fire_mode = FIRE_MODE::PROJECTILE;
+	Entity target = Entity::none();	// valid while has_target is set
+	bool has_target = false;
+	float retarget_ms = 0.f;	// until the next re-acquisition
+	bool tracer = true;	// hit-scan only: draw a short-lived line to the impact point
 };
 
 // Invader
 struct Invader {
 	int health;
 	int points = 1 + (rand() % 5); 
+	bool coverage_tracked = false;	// followed by the tower coverage map (see coverage_map.hpp)
 };
 
 struct Points {
@@ -45,11 +81,30 @@ struct Projectile {
 	int damage;
 };
 
+// A hit-scan shot in flight: the damage lands when time_ms runs out
+struct PendingHit {
+	Entity invader;
+	float time_ms;
+	int damage;
+};
+
+// Cosmetic hit-scan trail, it has no effect on the game and is removed when the timer runs out
+struct Tracer {
+	float timer_ms = TRACER_LIFETIME_MS;
+};
+
 struct Explosion {
 	float timer;
 	float frame;
 };
 
+// Entities that never move (level tiles, towers): skipped by integration, and
+// their colliders live in the prebuilt static layer (see static_layer.hpp)
+struct StaticBody
+{
+
+};
+
 // =============================================
 // CK: ignore these legacy components
 
@@ -74,12 +129,40 @@ struct Motion {
 	vec2  scale    = { 10, 10 };
 };
 
-// Stucture to store collision information
-struct Collision
+// Collision shape, centered on the entity's Motion position
+enum class COLLIDER_SHAPE {
+	CIRCLE = 0,	// projectiles
+	AABB = 1	// invaders and towers
+};
+
+struct Collider {
+	COLLIDER_SHAPE shape = COLLIDER_SHAPE::AABB;
+	vec2 half_extents = { 0, 0 };	// AABB only
+	float radius = 0.f;				// CIRCLE only
+};
+
+// Collision layers, one per kind of body that takes part in collision detection
+enum class COLLISION_LAYER : uint8_t {
+	INVADER = 0,
+	TOWER = 1,
+	PROJECTILE = 2,
+	LAYER_COUNT = PROJECTILE + 1
+};
+
+// key of an unordered pair of layers, lower layer first
+constexpr uint8_t layer_pair(COLLISION_LAYER a, COLLISION_LAYER b)
 {
-	// Note, the first object is stored in the ECS container.entities
-	Entity other; // the second object involved in the collision
-	Collision(Entity& other) { this->other = other; };
+	return a <= b
+		? (uint8_t)((uint8_t)a * (uint8_t)COLLISION_LAYER::LAYER_COUNT + (uint8_t)b)
+		: (uint8_t)((uint8_t)b * (uint8_t)COLLISION_LAYER::LAYER_COUNT + (uint8_t)a);
+}
+
+// A pair of overlapping bodies, lo is the one on the lower layer
+struct Contact
+{
+	Entity lo;
+	Entity hi;
+	uint8_t layer_pair;
 };
 
 // Data structure for toggling debug mode
@@ -229,8 +312,16 @@ enum class TEXTURE_ASSET_ID {
 	EXPLOSION2 = EXPLOSION1 + 1,
 	EXPLOSION3 = EXPLOSION2 + 1,
 
+	// the other tower types, TOWER is the first (see tower_types.hpp)
+	TOWER_2 = EXPLOSION3 + 1,
+	TOWER_3 = TOWER_2 + 1,
+	TOWER_4 = TOWER_3 + 1,
+	TOWER_5 = TOWER_4 + 1,
+	TOWER_6 = TOWER_5 + 1,
+	TOWER_7 = TOWER_6 + 1,
+
 	// TEXTURE_COUNT must always be the last entry
-	TEXTURE_COUNT = EXPLOSION3 + 1,
+	TEXTURE_COUNT = TOWER_7 + 1,
 };
 const int texture_count = (int)TEXTURE_ASSET_ID::TEXTURE_COUNT;
 
@@ -307,7 +398,9 @@ struct FilledTile {
 	vec3 color;
 };
 
-// A2: a walking path of vec2(x, y) coordinates
-struct WalkingPath {
-	std::vector<ivec2> path;
+// an invader's place in the shared flow field (see flow_field.hpp)
+struct FlowCursor {
+	ivec2 cell = { 0, 0 };			// the tile whose center the invader is walking toward, the next corner of its route
+	uint32_t field_revision = 0;	// flow_field.revision() when cell was picked
+	bool reached_exit = false;
 };
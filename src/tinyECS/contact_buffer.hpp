@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "components.hpp"
+
+// Contacts found by the physics system for one frame, consumed by WorldSystem::handle_collisions.
+// Each overlapping pair is stored once: lo is the body on the lower collision layer, and the
+// layer pair says which handler applies, so nothing has to be looked up per contact.
+// The storage is reserved up front and reused every frame.
+class ContactBuffer
+{
+public:
+	ContactBuffer() { contacts.reserve(MAX_CONTACTS); }
+
+	void push(Entity lo, Entity hi, uint8_t layer_pair) { contacts.push_back({ lo, hi, layer_pair }); }
+
+	// order by entity pair so the handlers see the same sequence however the contacts were found
+	void sort()
+	{
+		std::sort(contacts.begin(), contacts.end(), [](const Contact& a, const Contact& b) {
+			if (a.lo.id() != b.lo.id())
+				return a.lo.id() < b.lo.id();
+			return a.hi.id() < b.hi.id();
+		});
+	}
+
+	void clear() { contacts.clear(); }
+	size_t size() const { return contacts.size(); }
+
+	std::vector<Contact>::const_iterator begin() const { return contacts.begin(); }
+	std::vector<Contact>::const_iterator end() const { return contacts.end(); }
+
+private:
+	std::vector<Contact> contacts;
+};
@@ -6,6 +6,8 @@ class Entity
     unsigned int m_id;
     static unsigned int id_count;   // defaults to 0 (invalid), need to init 1
 
+    explicit Entity(unsigned int id) : m_id(id) {}
+
 public:
 
     Entity()
@@ -25,7 +27,11 @@ public:
     {
     }
 
+    // the invalid id 0, for members that only hold an entity some of the time; unlike
+    // the default constructor it does not use up an id
+    static Entity none() { return Entity(0u); }
+
     operator unsigned int() { return m_id; } // enables automatic casting to int
 
-    unsigned int id() { return m_id; }
+    unsigned int id() const { return m_id; }
 };
\ No newline at end of file
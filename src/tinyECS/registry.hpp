@@ -4,6 +4,7 @@
 
 #include "tiny_ecs.hpp"
 #include "components.hpp"
+#include "contact_buffer.hpp"
 #include <unordered_map>
 
 class ECSRegistry
@@ -19,7 +20,6 @@ public:
 	ComponentContainer<Text> texts;
 	ComponentContainer<Character> characters;
 	ComponentContainer<Motion> motions;
-	ComponentContainer<Collision> collisions;
 	ComponentContainer<Player> players;
 	ComponentContainer<Mesh*> meshPtrs;
 	ComponentContainer<RenderRequest> renderRequests;
@@ -32,13 +32,15 @@ public:
 	ComponentContainer<Tower> towers;
 	ComponentContainer<GridLine> gridLines;
 	ComponentContainer<Invader> invaders;
-	ComponentContainer<Projectile> projectiles;
 	ComponentContainer<Tile> tiles;
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	// A2: new for A2
 	ComponentContainer<FilledTile> filledTiles;
 	ComponentContainer<Selectable> selectables;
-	ComponentContainer<WalkingPath> walkingPaths;
+	ComponentContainer<FlowCursor> flowCursors;
+	ComponentContainer<Collider> colliders;
+	ComponentContainer<StaticBody> staticBodies;
+	ComponentContainer<Tracer> tracers;
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
 	// constructor that adds all containers for looping over them
@@ -46,7 +48,6 @@ public:
 	{
 		registry_list.push_back(&deathTimers);
 		registry_list.push_back(&motions);
-		registry_list.push_back(&collisions);
 		registry_list.push_back(&players);
 		registry_list.push_back(&meshPtrs);
 		registry_list.push_back(&renderRequests);
@@ -58,19 +59,23 @@ public:
 		registry_list.push_back(&towers);
 		registry_list.push_back(&gridLines);
 		registry_list.push_back(&invaders);
-		registry_list.push_back(&projectiles);
 		registry_list.push_back(&tiles);
 		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 		// A2
 		registry_list.push_back(&filledTiles);
 		registry_list.push_back(&selectables);
-		registry_list.push_back(&walkingPaths);
+		registry_list.push_back(&flowCursors);
+		registry_list.push_back(&colliders);
+		registry_list.push_back(&staticBodies);
+		registry_list.push_back(&tracers);
 		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	}
 
 	void clear_all_components() {
 		for (ContainerInterface* reg : registry_list)
 			reg->clear();
+		contacts.clear();
+		pending_hits.clear();
 	}
 
 	void list_all_components() {
@@ -94,6 +99,12 @@ public:
 
 	std::unordered_map<char, Character> character_map;
 
+	// this frame's collisions, filled by the physics system
+	ContactBuffer contacts;
+
+	// hit-scan shots scheduled by the AI system, applied by the world system at impact
+	std::vector<PendingHit> pending_hits;
+
 };
 
 extern ECSRegistry registry;
\ No newline at end of file
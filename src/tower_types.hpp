@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/components.hpp"
+
+// Stats of every tower archetype, one array per stat indexed by TOWER_TYPE.
+// NOTE: the arrays must be _manually_ aligned to TOWER_TYPE
+struct TowerArchetypes {
+	float range[(int)TOWER_TYPE::TYPE_COUNT];
+	int fire_ms[(int)TOWER_TYPE::TYPE_COUNT];	// between shots
+	int damage[(int)TOWER_TYPE::TYPE_COUNT];	// per shot
+	float projectile_speed[(int)TOWER_TYPE::TYPE_COUNT];
+	TARGET_POLICY targeting[(int)TOWER_TYPE::TYPE_COUNT];	// default, can be changed per tower
+	TEXTURE_ASSET_ID texture[(int)TOWER_TYPE::TYPE_COUNT];
+};
+
+constexpr TowerArchetypes TOWER_ARCHETYPES = {
+	/* range */
+	{ 5.f * GRID_CELL_WIDTH_PX, 4.f * GRID_CELL_WIDTH_PX, 9.f * GRID_CELL_WIDTH_PX, 4.f * GRID_CELL_WIDTH_PX,
+	  5.f * GRID_CELL_WIDTH_PX, 6.f * GRID_CELL_WIDTH_PX, 6.f * GRID_CELL_WIDTH_PX },
+	/* fire_ms */
+	{ TOWER_TIMER_MS, 350, 2000, 1200, 1600, 700, 900 },
+	/* damage */
+	{ PROJECTILE_DAMAGE, 4, 35, 8, 25, 8, 10 },
+	/* projectile_speed */
+	{ PROJECTILE_SPEED, 1100.f, 1800.f, 900.f, 700.f, 1200.f, PROJECTILE_SPEED },
+	/* targeting */
+	{ TARGET_POLICY::CLOSEST, TARGET_POLICY::FIRST, TARGET_POLICY::STRONGEST, TARGET_POLICY::CLOSEST,
+	  TARGET_POLICY::FIRST, TARGET_POLICY::WEAKEST, TARGET_POLICY::LAST },
+	/* texture */
+	{ TEXTURE_ASSET_ID::TOWER, TEXTURE_ASSET_ID::TOWER_2, TEXTURE_ASSET_ID::TOWER_3, TEXTURE_ASSET_ID::TOWER_4,
+	  TEXTURE_ASSET_ID::TOWER_5, TEXTURE_ASSET_ID::TOWER_6, TEXTURE_ASSET_ID::TOWER_7 },
+};
+
+// How a tower type fires, fixed at compile time so each type's fire loop has no per-tower
+// branching: SHOTS projectiles fanned out SPREAD_DEG apart around the aim direction.
+template <TOWER_TYPE type>
+struct TowerFire {
+	static constexpr int SHOTS = 1;
+	static constexpr float SPREAD_DEG = 0.f;
+};
+
+template <>
+struct TowerFire<TOWER_TYPE::SCATTER> {
+	static constexpr int SHOTS = 3;
+	static constexpr float SPREAD_DEG = 15.f;
+};
@@ -0,0 +1,95 @@
+// internal
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t num_workers)
+{
+	if (num_workers == 0)
+		num_workers = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t worker = 1; worker < num_workers; worker++)
+		threads.emplace_back(&WorkerPool::worker_main, this, worker);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_ready.notify_all();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+// range of worker w when count items are split over workers
+static void worker_range(size_t count, size_t workers, size_t w, size_t& begin, size_t& end)
+{
+	begin = count * w / workers;
+	end = count * (w + 1) / workers;
+}
+
+void WorkerPool::parallel_for(size_t count, size_t min_per_worker,
+	const std::function<void(size_t, size_t, size_t)>& fn)
+{
+	if (count == 0)
+		return;
+
+	size_t workers = std::min(size(), std::max<size_t>(1, count / std::max<size_t>(1, min_per_worker)));
+	if (workers == 1) {
+		fn(0, 0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &fn;
+		job_count = count;
+		job_workers = workers;
+		pending = workers - 1;
+		generation++;
+	}
+	work_ready.notify_all();
+
+	size_t begin, end;
+	worker_range(count, workers, 0, begin, end);
+	fn(0, begin, end);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	work_done.wait(lock, [this] { return pending == 0; });
+	job = nullptr;
+}
+
+void WorkerPool::worker_main(size_t worker)
+{
+	size_t seen_generation = 0;
+	for (;;) {
+		const std::function<void(size_t, size_t, size_t)>* current;
+		size_t count, workers;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+			if (stopping)
+				return;
+			seen_generation = generation;
+			current = job;
+			count = job_count;
+			workers = job_workers;
+		}
+
+		// workers beyond this job's split sit it out
+		if (worker >= workers)
+			continue;
+
+		size_t begin, end;
+		worker_range(count, workers, worker, begin, end);
+		(*current)(worker, begin, end);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending--;
+		}
+		work_done.notify_one();
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small pool of persistent worker threads for data-parallel loops.
+// The calling thread takes part as worker 0, so a pool of N workers starts N - 1
+// threads. Jobs must not touch the registry, only their own inputs and outputs.
+class WorkerPool
+{
+public:
+	// num_workers = 0 picks one worker per hardware thread
+	explicit WorkerPool(size_t num_workers = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	size_t size() const { return threads.size() + 1; }
+
+	// splits [0, count) into contiguous ranges and calls job(worker, begin, end) once per
+	// range, blocking until all are done. At most count / min_per_worker workers are used,
+	// so small loops run inline without waking anyone.
+	void parallel_for(size_t count, size_t min_per_worker,
+		const std::function<void(size_t worker, size_t begin, size_t end)>& job);
+
+private:
+	void worker_main(size_t worker);
+
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+
+	// current job, guarded by mutex
+	const std::function<void(size_t, size_t, size_t)>* job = nullptr;
+	size_t job_count = 0;
+	size_t job_workers = 0;
+	size_t generation = 0;
+	size_t pending = 0;
+	bool stopping = false;
+};
@@ -1,4 +1,10 @@
 #include "world_init.hpp"
+#include "flow_field.hpp"
+#include "projectile_pool.hpp"
+#include "static_layer.hpp"
+#include "coverage_map.hpp"
+#include "tile_grid.hpp"
+#include "tower_types.hpp"
 #include "tinyECS/registry.hpp"
 #include <iostream>
 
@@ -62,7 +68,8 @@ Entity createFilledTile(RenderSystem* renderer, vec2 position, vec2 size, vec3 c
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // !!! TODO A2: add level tiles
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-Entity createLevelTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID new_tile_id)
+// the tile entity shared by level and tile-selector tiles
+static Entity createTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID new_tile_id)
 {
 	Entity entity = Entity();
 
@@ -89,6 +96,7 @@ Entity createLevelTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID n
 		
 	);
 	motion.scale = vec2({ TILE_BB_WIDTH, TILE_BB_HEIGHT });
+	registry.staticBodies.emplace(entity);
 
 	registry.renderRequests.insert(
 		entity,
@@ -102,6 +110,13 @@ Entity createLevelTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID n
 	return entity;
 }
 
+Entity createLevelTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID new_tile_id)
+{
+	Entity entity = createTile(renderer, position, new_tile_id);
+	tile_grid.add(entity, registry.tiles.get(entity));
+	return entity;
+}
+
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // TODO A2: create a selectable tile for the tile-selector screen
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -109,7 +124,8 @@ Entity createSelectableTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET
 {
 	// TODO A2: create a new (level) tile entity
 	// auto entity = Entity(); // Entity(); needs to be replaced, used here to quel compiler warning
-	Entity entity = createLevelTile(renderer, position, new_tile_id);
+	// not part of the level, so it stays out of the tile grid
+	Entity entity = createTile(renderer, position, new_tile_id);
 
 
 	// TODO A2: add the extra "selectable" component
@@ -148,6 +164,7 @@ Entity createInvader(RenderSystem* renderer, vec2 position)
 	// resize, set scale to negative if you want to make it face the opposite way
 	// motion.scale = vec2({ -INVADER_BB_WIDTH, INVADER_BB_WIDTH });
 	motion.scale = vec2({ INVADER_BB_WIDTH, INVADER_BB_HEIGHT });
+	registry.colliders.emplace(entity, Collider{ COLLIDER_SHAPE::AABB, { INVADER_BODY_WIDTH / 2.f, INVADER_BODY_HEIGHT / 2.f } });
 	
 
 	int rng = 1 + (rand() % 3);
@@ -188,14 +205,18 @@ Entity createInvader(RenderSystem* renderer, vec2 position)
 	return entity;
 }
 
-Entity createTower(RenderSystem* renderer, vec2 position)
+Entity createTower(RenderSystem* renderer, vec2 position, TOWER_TYPE type)
 {
 	auto entity = Entity();
 
-	// new tower
+	// new tower, its stats come from the archetype table
 	auto& t = registry.towers.emplace(entity);
-	t.range = 5 * GRID_CELL_WIDTH_PX;
-	t.timer_ms = TOWER_TIMER_MS;	// arbitrary for now
+	t.type = type;
+	t.range = TOWER_ARCHETYPES.range[(int)type];
+	t.timer_ms = TOWER_ARCHETYPES.fire_ms[(int)type];
+	t.targeting = TOWER_ARCHETYPES.targeting[(int)type];
+	// stagger re-acquisition by tower index so towers do not all retarget on the same frame
+	t.retarget_ms = TOWER_RETARGET_MS * (float)((registry.towers.size() - 1) % TOWER_RETARGET_SLOTS) / TOWER_RETARGET_SLOTS;
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
@@ -211,13 +232,17 @@ Entity createTower(RenderSystem* renderer, vec2 position)
 
 	// Setting initial values, scale is negative to make it face the opposite way
 	motion.scale = vec2({ -TOWER_BB_WIDTH, TOWER_BB_HEIGHT });
+	registry.colliders.emplace(entity, Collider{ COLLIDER_SHAPE::AABB, { TOWER_BODY_WIDTH / 2.f, TOWER_BODY_HEIGHT / 2.f } });
+	registry.staticBodies.emplace(entity);
+	static_layer.invalidate();
+	coverage_map.invalidate();
 
 	// create an (empty) Tower component to be able to refer to all towers
 	registry.deadlys.emplace(entity);
 	registry.renderRequests.insert(
 		entity,
 		{
-			TEXTURE_ASSET_ID::TOWER,
+			TOWER_ARCHETYPES.texture[(int)type],
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		}
@@ -226,6 +251,19 @@ Entity createTower(RenderSystem* renderer, vec2 position)
 	return entity;
 }
 
+void setTowerType(Entity tower_entity, TOWER_TYPE type)
+{
+	Tower& tower = registry.towers.get(tower_entity);
+	tower.type = type;
+	tower.range = TOWER_ARCHETYPES.range[(int)type];
+	tower.timer_ms = min(tower.timer_ms, TOWER_ARCHETYPES.fire_ms[(int)type]);
+	tower.targeting = TOWER_ARCHETYPES.targeting[(int)type];
+	registry.renderRequests.get(tower_entity).used_texture = TOWER_ARCHETYPES.texture[(int)type];
+
+	// the range changed
+	coverage_map.invalidate();
+}
+
 void removeTower(vec2 position) {
 	// remove any towers at this position
 	for (Entity& tower_entity : registry.towers.entities) {
@@ -233,8 +271,13 @@ void removeTower(vec2 position) {
 		const Motion& tower_motion = registry.motions.get(tower_entity);
 		
 		if (tower_motion.position.y == position.y) {
+			// a tower standing on the path (mazing) frees its cell again
+			flow_field.unblock(ivec2(tower_motion.position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)));
+
 			// remove this tower
 			registry.remove_all_components_of(tower_entity);
+			static_layer.invalidate();
+			coverage_map.invalidate();
 			std::cout << "tower removed" << std::endl;
 		}
 	}
@@ -243,28 +286,35 @@ void removeTower(vec2 position) {
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // !!! TODO A1: create a new projectile w/ pos, size, & velocity
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-Entity createProjectile(vec2 pos, vec2 size, vec2 velocity)
+bool createProjectile(vec2 pos, vec2 size, vec2 velocity, int damage)
 {
-	auto entity = Entity();
-
-	registry.projectiles.emplace(entity, Projectile{ PROJECTILE_DAMAGE });
+	// projectiles live in a fixed pool (see projectile_pool.hpp), not in the registry
+	return projectile_pool.spawn(pos, size, velocity, damage);
+}
 
-	// Motion:
-	auto& motion = registry.motions.emplace(entity);
-	motion.position = pos;
-	motion.scale = size;
-	motion.velocity = velocity;
+Entity createTracer(vec2 from, vec2 to)
+{
+	Entity entity = Entity();
 
-	// Render
 	registry.renderRequests.insert(
 		entity,
 		{
-			TEXTURE_ASSET_ID::PROJECTILE,  // Use the correct projectile texture
-			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE
+			TEXTURE_ASSET_ID::TEXTURE_COUNT,
+			EFFECT_ASSET_ID::EGG,
+			GEOMETRY_BUFFER_ID::DEBUG_LINE
 		}
 	);
 
+	// a unit line stretched and rotated to span from -> to
+	vec2 span = to - from;
+	Motion& motion = registry.motions.emplace(entity);
+	motion.position = (from + to) / 2.f;
+	motion.angle = glm::degrees(atan2(span.y, span.x));
+	motion.velocity = { 0, 0 };
+	motion.scale = { glm::length(span), 2.f };
+
+	registry.colors.emplace(entity) = vec3(1.f, 0.9f, 0.4f);
+	registry.tracers.emplace(entity);
 	return entity;
 }
 
@@ -8,9 +8,12 @@
 Entity createInvader(RenderSystem* renderer, vec2 position);
 
 // towers
-Entity createTower(RenderSystem* renderer, vec2 position);
+Entity createTower(RenderSystem* renderer, vec2 position, TOWER_TYPE type = TOWER_TYPE::BASIC);
 void removeTower(vec2 position);
 
+// switch a tower to another archetype, taking over its stats and texture
+void setTowerType(Entity tower, TOWER_TYPE type);
+
 // A2: add level tile
 Entity createLevelTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET_ID new_tile_id);
 
@@ -20,8 +23,11 @@ Entity createSelectableTile(RenderSystem* renderer, vec2 position, TEXTURE_ASSET
 // A2: tile cell outline overlay
 Entity createFilledTile(RenderSystem* renderer, vec2 position, vec2 size, vec3 color);
 
-// projectile
-Entity createProjectile(vec2 pos, vec2 size, vec2 velocity);
+// projectile, taken from the projectile pool; false if the pool is exhausted
+bool createProjectile(vec2 pos, vec2 size, vec2 velocity, int damage = PROJECTILE_DAMAGE);
+
+// cosmetic hit-scan trail between two points
+Entity createTracer(vec2 from, vec2 to);
 
 // grid lines to show tile positions
 Entity createGridLine(vec2 start_pos, vec2 end_pos, vec3 color);
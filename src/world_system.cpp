@@ -15,6 +15,11 @@
 #include "physics_system.hpp"
 #include "tiles.hpp"
 #include "pathing.hpp"
+#include "flow_field.hpp"
+#include "projectile_pool.hpp"
+#include "static_layer.hpp"
+#include "coverage_map.hpp"
+#include "tile_grid.hpp"
 
 // ADDED
 #include "tinyECS/components.hpp";
@@ -173,6 +178,8 @@ void WorldSystem::update_window_caption() {
 	title_ss << " | " << "Points: " << points;
 	title_ss << " | " << "Max Towers: " << max_towers;
 	title_ss << " | " << "Debug: " << (debugging.in_debug_mode ? "true" : "false");
+	title_ss << " | " << "Projectiles: " << projectile_pool.active_count() << "/" << projectile_pool.capacity()
+		<< " (peak " << projectile_pool.peak_active << ", dropped " << projectile_pool.dropped << ")";
 	glfwSetWindowTitle(window, title_ss.str().c_str());
 }
 
@@ -183,15 +190,33 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 		// see if an invader has reached the end
 		for (Entity invader : registry.invaders.entities) {
-			if (registry.walkingPaths.has(invader)) {
-				WalkingPath& wp = registry.walkingPaths.get(invader);
-				if (wp.path.empty()) {
+			if (registry.flowCursors.has(invader)) {
+				FlowCursor& cursor = registry.flowCursors.get(invader);
+				if (cursor.reached_exit) {
 					game_screen = GAME_SCREEN_ID::END;
 					break;
 				}
 			}
 		}
 
+		// hit-scan shots land once their time of impact has passed
+		for (PendingHit& hit : registry.pending_hits) {
+			hit.time_ms -= elapsed_ms_since_last_update;
+			if (hit.time_ms <= 0.f && registry.invaders.has(hit.invader))
+				damage_invader(hit.invader, hit.damage);
+		}
+		registry.pending_hits.erase(
+			std::remove_if(registry.pending_hits.begin(), registry.pending_hits.end(),
+				[](const PendingHit& hit) { return hit.time_ms <= 0.f; }),
+			registry.pending_hits.end());
+
+		for (int i = (int)registry.tracers.entities.size() - 1; i >= 0; i--) {
+			Tracer& tracer = registry.tracers.components[i];
+			tracer.timer_ms -= elapsed_ms_since_last_update;
+			if (tracer.timer_ms <= 0.f)
+				registry.remove_all_components_of(registry.tracers.entities[i]);
+		}
+
 		for (Entity invader : registry.invaders.entities) {
 			Motion& m = registry.motions.get(invader);
 			vec2 pos = m.position - vec2(m.scale.x / 2.f, m.scale.y / 2.f);
@@ -262,11 +287,16 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		if (invaders_remaining > 0) {
 			addUnspawnedText(invaders_remaining);
 			next_invader_spawn -= elapsed_ms_since_last_update;
-			if (next_invader_spawn <= 0) {
-				// Generate a small random offset so invaders don't spawn exactly on top of one another.
-				Entity invader = createInvader(renderer, spawn_start_position);
-				WalkingPath& invader_path = registry.walkingPaths.emplace(invader);
-				invader_path.path = spawn_path;
+			if (next_invader_spawn <= 0 && !spawn_tiles.empty()) {
+				// every spawn walks the same flow field, so each one only needs a cursor on its start tile
+				ivec2 spawn_tile = spawn_tiles[next_spawn];
+				next_spawn = (next_spawn + 1) % spawn_tiles.size();
+				vec2 spawn_position = vec2((spawn_tile.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f) - GRID_CELL_WIDTH_PX,
+					(spawn_tile.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f) - GRID_CELL_HEIGHT_PX);
+				Entity invader = createInvader(renderer, spawn_position);
+				FlowCursor& cursor = registry.flowCursors.emplace(invader);
+				cursor.cell = spawn_tile;
+				cursor.field_revision = flow_field.revision();
 
 				invaders_remaining--;
 
@@ -502,18 +532,7 @@ bool WorldSystem::find_first_start_tile(glm::ivec2& start_tile)
 {
 	std::cout << "Searching for Start Tile..." << std::endl;
 
-	for (Entity entity : registry.tiles.entities) {
-		Tile& tile = registry.tiles.get(entity);
-		// std::cout << "Checking Tile at (" << tile.tx << ", " << tile.ty << ") with ID " << (int)tile.tile_id << std::endl;
-
-		if (START_TILES.find(tile.tile_id) != START_TILES.end()) {
-			start_tile = glm::ivec2(tile.tx, tile.ty);
-			//std::cout << "Start Tile Found at (" << start_tile.x << ", " << start_tile.y << ")" << std::endl;
-			return true;
-		}
-	}
-
-	return false;
+	return tile_grid.first_start(start_tile);
 }
 
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -521,22 +540,19 @@ bool WorldSystem::find_first_start_tile(glm::ivec2& start_tile)
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 bool WorldSystem::find_first_exit_tile(glm::ivec2& exit_tile)
 {
-	for (Entity entity : registry.tiles.entities) {
-		Tile& tile = registry.tiles.get(entity);
-		// std::cout << "Checking Tile at (" << tile.tx << ", " << tile.ty << ") with ID " << (int)tile.tile_id << std::endl;
-
-		if (EXIT_TILES.find(tile.tile_id) != EXIT_TILES.end()) {
-			exit_tile = glm::ivec2(tile.tx, tile.ty);
-			// std::cout << "Exit Tile Found at (" << exit_tile.x << ", " << exit_tile.y << ")" << std::endl;
-			return true;
-		}
-	}
-	return false;
+	return tile_grid.first_exit(exit_tile);
+}
+
+Tile* WorldSystem::getTileAt(const glm::ivec2& coord)
+{
+	if (!tile_grid.has(coord))
+		return nullptr;
+	return &registry.tiles.get(tile_grid.entity_at(coord));
 }
 
 ivec2 WorldSystem::getStartTile()
 {
-	return startTile;
+	return spawn_tiles.empty() ? ivec2(0, 0) : spawn_tiles.front();
 }
 
 
@@ -562,6 +578,13 @@ void WorldSystem::restart_game() {
 	// remove all motion entities
 	while (registry.motions.entities.size() > 0)
 	    registry.remove_all_components_of(registry.motions.entities.back());
+	tile_grid.clear();
+	path_planner.invalidate();
+	path_hierarchy.invalidate();
+	projectile_pool.clear();
+	registry.pending_hits.clear();
+	static_layer.invalidate();
+	coverage_map.invalidate();
 
 	// A2: remove the filled tiles too (b/c they do not have motion)
 	//     legacy - only motion elements were removed, but we need to remove other things too
@@ -633,201 +656,101 @@ void WorldSystem::restart_game() {
 
 }
 
-// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-// TODO A2: search for a path from start to exit, only on the yellow tile lines
-//     If a path is found, return true and store it in reverse order from
-//     exit to start in the vector of ivec2 tile coordinates.
-//     If a path is not found, return false.
-// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-bool WorldSystem::find_path(std::vector<ivec2> & path)
-{
-	// TODO: use A*
-	// TODO: return true when a path is found and return the path via the &path vector
-
-	glm::ivec2 start_tile, exit_tile;
-	if (!find_first_start_tile(start_tile) || !find_first_exit_tile(exit_tile)) {
-		std::cout << "No valid start or exit tile found" << std::endl;
-		return false;
-	}
-
-	std::unordered_set<ivec2> closed_set;
-	std::unordered_map<ivec2, ivec2> parent_map;
-
-	std::priority_queue<Node, std::vector<Node>, std::function<bool(Node, Node)>> open_list(
-		[](const Node& a, const Node& b) { return a.get_score() > b.get_score(); }
-	);
-
-	open_list.emplace(start_tile, start_tile, 0, glm::distance(glm::vec2(start_tile), glm::vec2(exit_tile)));
-	parent_map[start_tile] = start_tile;  // Start node has no real parent
-
-	while (!open_list.empty()) {
-		Node current = open_list.top();
-		open_list.pop();
-
-		if (current.position == exit_tile) {
-			path.clear();
-			glm::ivec2 step = exit_tile;
-			while (step != start_tile) {
-				path.push_back(step);
-				step = parent_map[step];  // Move to parent tile
-			}
-			path.push_back(start_tile);
-			std::reverse(path.begin(), path.end());
-			// std::cout << "Path Found. Steps: " << path.size() << "\n";
-			return true;
-		}
-
-		closed_set.insert(current.position);
-
-		// Explore neighbors 
-		std::vector<ivec2> neighbors = {
-			{current.position.x, current.position.y - 1},
-			{current.position.x, current.position.y + 1},
-			{current.position.x - 1, current.position.y},
-			{current.position.x + 1, current.position.y}
-		};
-
-		for (const ivec2& neighbor : neighbors) {
-			if (closed_set.find(neighbor) != closed_set.end()) {
-				continue;  // Skip visited tiles
-			}
-			Tile* neighborTilePtr = nullptr;
-			Tile* currentTilePtr = nullptr;
-			for (Entity entity : registry.tiles.entities) {
-				Tile& tile = registry.tiles.get(entity);
-				if (tile.tx == neighbor.x && tile.ty == neighbor.y) {
-					neighborTilePtr = &tile;
-				}
-				if (tile.tx == current.position.x && tile.ty == current.position.y) {
-					currentTilePtr = &tile;
-				}
-				if (neighborTilePtr && currentTilePtr)
-					break;
-			}
-
-			if (!neighborTilePtr || !currentTilePtr)
-				continue;
-
-			glm::ivec2 direction = neighbor - current.position;
-			if (!canConnect(*currentTilePtr, *neighborTilePtr, direction))
-				continue;
-
-			uint g = current.G + 1;
-			uint h = glm::distance(glm::vec2(neighbor), glm::vec2(exit_tile));
-			open_list.emplace(neighbor, current.position, g, h);
-			parent_map[neighbor] = current.position;
-		}
-	}
-
-	std::cout << "No valid path found\n";
-	return false;
-}
-
-bool WorldSystem::canConnect(const Tile& current, const Tile& neighbor, const glm::ivec2& direction)
-{
-	auto current_it = TILE_DIRECTIONS.find(current.tile_id);
-	auto neighbor_it = TILE_DIRECTIONS.find(neighbor.tile_id);
-	if (current_it == TILE_DIRECTIONS.end() || neighbor_it == TILE_DIRECTIONS.end()) {
-		return false;
-	}
-	tile_dir currentDir = current_it->second;
-	tile_dir neighborDir = neighbor_it->second;
-
-
-	if (direction == glm::ivec2(0, -1)) {         //  up
-		return currentDir.top && neighborDir.bottom;
-	}
-	else if (direction == glm::ivec2(0, 1)) {     //down
-		return currentDir.bottom && neighborDir.top;
-	}
-	else if (direction == glm::ivec2(-1, 0)) {    // left
-		return currentDir.left && neighborDir.right;
-	}
-	else if (direction == glm::ivec2(1, 0)) {     // right
-		return currentDir.right && neighborDir.left;
-	}
-	return false;
-}
-	
-
-
 // Compute collisions between entities
 void WorldSystem::handle_collisions() {
 
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 	// TODO A1: Loop over all collisions detected by the physics system
 	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-	ComponentContainer<Collision>& collision_container = registry.collisions;
-	for (uint i = 0; i < collision_container.components.size(); i++) {
+	// each contact is stored once, lo on the lower layer (see COLLISION_LAYER)
+	for (const Contact& contact : registry.contacts) {
+		switch (contact.layer_pair) {
+		case layer_pair(COLLISION_LAYER::INVADER, COLLISION_LAYER::PROJECTILE):
+			on_projectile_hit(contact.lo, contact.hi);
+			break;
+		case layer_pair(COLLISION_LAYER::INVADER, COLLISION_LAYER::TOWER):
+			on_tower_reached(contact.lo, contact.hi);
+			break;
+		default:
+			break;
+		}
+	}
 
-		Entity e1 = collision_container.entities[i];
-		Entity e2 = collision_container.components[i].other;
+	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+	// TODO A2: When invaders reach the exit, their walkable path will be empty
+	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+	// Done in physics
 
-		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-		// TODO A1: handle collision between projectile and invader
-		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-		// Mix_PlayChannel(-1, chicken_dead_sound, 0);
+	registry.contacts.clear();
+}
 
-		if ((registry.projectiles.has(e1) && registry.invaders.has(e2)) || (registry.invaders.has(e1) && registry.projectiles.has(e2))) {
-			Entity projectile = registry.projectiles.has(e1) ? e1 : e2;
-			Entity invader = registry.invaders.has(e1) ? e1 : e2;
-			Motion& m = registry.motions.get(invader);
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// TODO A1: handle collision between projectile and invader
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+void WorldSystem::on_projectile_hit(Entity invader, Entity projectile) {
+	// either may already be gone after an earlier contact this frame
+	int slot = projectile_pool.slot_of(projectile);
+	if (!registry.invaders.has(invader) || slot < 0 || !projectile_pool.is_active(slot))
+		return;
 
-			std::cout << "Projectile hit an invader!" << std::endl;
+	std::cout << "Projectile hit an invader!" << std::endl;
 
+	const int damage = projectile_pool.projectiles[slot].damage;
+	projectile_pool.release(slot);
 
-			registry.remove_all_components_of(projectile);
+	damage_invader(invader, damage);
+}
 
-			Invader& invader_component = registry.invaders.get(invader);
-			invader_component.health -= PROJECTILE_DAMAGE;
+// shared by projectile hits and hit-scan shots
+void WorldSystem::damage_invader(Entity invader, int damage) {
+	Motion& m = registry.motions.get(invader);
+	Invader& invader_component = registry.invaders.get(invader);
+	invader_component.health -= damage;
 
-			if (invader_component.health <= 0) {
-				score += invader_component.points;
+	if (invader_component.health <= 0) {
+		score += invader_component.points;
 
-				createExplosion(m.position);
+		createExplosion(m.position);
 
-				registry.remove_all_components_of(invader);
-				Mix_PlayChannel(-1, chicken_dead_sound, 0);
-			}
-			else {
-				std::cout << "Invader took damage! Remaining Health: " << invader_component.health << std::endl;
-			}
-		}
+		registry.remove_all_components_of(invader);
+		Mix_PlayChannel(-1, chicken_dead_sound, 0);
+	}
+	else {
+		std::cout << "Invader took damage! Remaining Health: " << invader_component.health << std::endl;
+	}
+}
 
-		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-		// TODO A1: handle collision between tower and invader
-		// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-		// Mix_PlayChannel(-1, chicken_eat_sound, 0);
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// TODO A1: handle collision between tower and invader
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+void WorldSystem::on_tower_reached(Entity invader, Entity tower) {
+	if (!registry.invaders.has(invader) || !registry.towers.has(tower))
+		return;
 
-		if (registry.invaders.has(e1) && registry.towers.has(e2)) {
-			registry.remove_all_components_of(e2);
-			registry.remove_all_components_of(e1);
+	// a tower standing on the path (mazing) frees its cell again
+	Motion& tower_motion = registry.motions.get(tower);
+	flow_field.unblock(ivec2(tower_motion.position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)));
 
-			if (max_towers > 0) {
-				max_towers--;
-			}
+	registry.remove_all_components_of(tower);
+	registry.remove_all_components_of(invader);
+	static_layer.invalidate();
+	coverage_map.invalidate();
 
-			Mix_PlayChannel(-1, chicken_eat_sound, 0);
-			std::cout << "Tower destroyed! Remaining max towers: " << max_towers << std::endl;
-
-			// assert(registry.screenStates.components.size() <= 1);
-			if (!registry.screenStates.components.empty()) {
-				//registry.screenStates.components[0].vignette_intensity = 1.0f;
-				/*std::cout << "Vignette triggered! Intensity set to: "
-					<< registry.screenStates.components[0].vignette_intensity << std::endl;*/
-				Entity vignetteEntity = Entity();
-				registry.deathTimers.emplace(vignetteEntity, DeathTimer{ 1000.0f });
-				
-			}
-		}
+	if (max_towers > 0) {
+		max_towers--;
 	}
 
-	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-	// TODO A2: When invaders reach the exit, their walkable path will be empty
-	// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-	// Done in physics
+	Mix_PlayChannel(-1, chicken_eat_sound, 0);
+	std::cout << "Tower destroyed! Remaining max towers: " << max_towers << std::endl;
 
-	registry.collisions.clear();
+	// assert(registry.screenStates.components.size() <= 1);
+	if (!registry.screenStates.components.empty()) {
+		//registry.screenStates.components[0].vignette_intensity = 1.0f;
+		/*std::cout << "Vignette triggered! Intensity set to: "
+			<< registry.screenStates.components[0].vignette_intensity << std::endl;*/
+		Entity vignetteEntity = Entity();
+		registry.deathTimers.emplace(vignetteEntity, DeathTimer{ 1000.0f });
+	}
 }
 
 // Should the game be over ?
@@ -858,6 +781,16 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	}
 
 
+	// A2: arrow keys - scroll the map under the window, one cell (SHIFT: a screen) at a time
+	if ((action == GLFW_PRESS || action == GLFW_REPEAT)
+		&& (game_screen == GAME_SCREEN_ID::DRAWING || game_screen == GAME_SCREEN_ID::PLAYING)) {
+		ivec2 cells = shift_key_pressed ? ivec2(NUM_GRID_CELLS_WIDE - 1, NUM_GRID_CELLS_HIGH - 1) : ivec2(1, 1);
+		if (key == GLFW_KEY_LEFT)  move_camera(ivec2(-cells.x, 0));
+		if (key == GLFW_KEY_RIGHT) move_camera(ivec2(cells.x, 0));
+		if (key == GLFW_KEY_UP)    move_camera(ivec2(0, -cells.y));
+		if (key == GLFW_KEY_DOWN)  move_camera(ivec2(0, cells.y));
+	}
+
 	// ESC - exit game
 	if (action == GLFW_RELEASE && key == GLFW_KEY_ESCAPE) {
 		if (game_screen != GAME_SCREEN_ID::INTRO) {
@@ -869,6 +802,13 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 			for (Entity e : motionsToClear) {
 				registry.remove_all_components_of(e);
 			}
+			tile_grid.clear();
+			path_planner.invalidate();
+			path_hierarchy.invalidate();
+			projectile_pool.clear();
+			registry.pending_hits.clear();
+			static_layer.invalidate();
+			coverage_map.invalidate();
 			while (!registry.filledTiles.entities.empty()) {
 				Entity e = registry.filledTiles.entities.back();
 				registry.remove_all_components_of(e);
@@ -896,6 +836,63 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 			shift_key_pressed = true;
 	}
 
+	// M - mazing: allow towers on path tiles, invaders reroute around them
+	if (action == GLFW_RELEASE && key == GLFW_KEY_M) {
+		mazing = !mazing;
+		std::cout << "INFO: mazing " << (mazing ? "enabled" : "disabled") << std::endl;
+	}
+
+	// H - hit-scan: cycle the tower under the mouse through projectile, hit-scan and hit-scan without tracer
+	if (action == GLFW_RELEASE && key == GLFW_KEY_H) {
+		ivec2 cell = mouse_cell();
+		for (Entity e : registry.towers.entities) {
+			if (ivec2(registry.motions.get(e).position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)) != cell)
+				continue;
+
+			Tower& tower = registry.towers.get(e);
+			if (tower.fire_mode == FIRE_MODE::PROJECTILE) {
+				tower.fire_mode = FIRE_MODE::HIT_SCAN;
+				tower.tracer = true;
+			}
+			else if (tower.tracer) {
+				tower.tracer = false;
+			}
+			else {
+				tower.fire_mode = FIRE_MODE::PROJECTILE;
+			}
+			std::cout << "INFO: tower fire mode " << (tower.fire_mode == FIRE_MODE::HIT_SCAN ? "hit-scan" : "projectile")
+				<< (tower.fire_mode == FIRE_MODE::HIT_SCAN && !tower.tracer ? " (no tracer)" : "") << std::endl;
+		}
+	}
+
+	// F - cycle the targeting policy of the tower under the mouse
+	if (action == GLFW_RELEASE && key == GLFW_KEY_F) {
+		static const char* POLICY_NAMES[] = { "closest", "first", "last", "strongest", "weakest" };
+		ivec2 cell = mouse_cell();
+		for (Entity e : registry.towers.entities) {
+			if (ivec2(registry.motions.get(e).position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)) != cell)
+				continue;
+
+			Tower& tower = registry.towers.get(e);
+			tower.targeting = (TARGET_POLICY)(((int)tower.targeting + 1) % (int)TARGET_POLICY::POLICY_COUNT);
+			std::cout << "INFO: tower targeting " << POLICY_NAMES[(int)tower.targeting] << std::endl;
+		}
+	}
+
+	// T - cycle the type of the tower under the mouse
+	if (action == GLFW_RELEASE && key == GLFW_KEY_T) {
+		static const char* TYPE_NAMES[] = { "basic", "rapid", "sniper", "scatter", "heavy", "finisher", "rearguard" };
+		ivec2 cell = mouse_cell();
+		for (Entity e : registry.towers.entities) {
+			if (ivec2(registry.motions.get(e).position / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)) != cell)
+				continue;
+
+			TOWER_TYPE type = (TOWER_TYPE)(((int)registry.towers.get(e).type + 1) % (int)TOWER_TYPE::TYPE_COUNT);
+			setTowerType(e, type);
+			std::cout << "INFO: tower type " << TYPE_NAMES[(int)type] << std::endl;
+		}
+	}
+
 	// D - Debugging - not used in A1, but left intact for the debug lines
 	if (key == GLFW_KEY_D) {
 		if (action == GLFW_RELEASE) {
@@ -913,7 +910,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	// A2: E - tile selector toggle
 	if (key == GLFW_KEY_E) {
 		if (action == GLFW_RELEASE) {
-			clear_filled_tiles();
+			hide_path_overlay();
 
 			// toggle between the drawing screen and the tile selector screen
 			if (game_screen == GAME_SCREEN_ID::DRAWING) {
@@ -984,37 +981,12 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 
 	// A2: O - calculate path manually
 	if (action == GLFW_RELEASE && key == GLFW_KEY_O && game_screen == GAME_SCREEN_ID::DRAWING) {
-		std::vector<glm::ivec2> final_path;
-		std::unordered_set<glm::ivec2> visited_tiles;
 		if (showpath) {
 			showpath = false;
-			bool path_found = find_path_with_visitation(final_path, visited_tiles);
-
-			clear_filled_tiles();
-
-			for (const auto& tile_coord : visited_tiles) {
-				vec2 tile_pos = { tile_coord.x * GRID_CELL_WIDTH_PX, tile_coord.y * GRID_CELL_HEIGHT_PX };
-				createFilledTile(renderer, tile_pos, vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX), vec3(0, 0, 1));
-			}
-
-			if (path_found) {
-				for (const auto& tile_coord : final_path) {
-					vec2 tile_pos = { tile_coord.x * GRID_CELL_WIDTH_PX, tile_coord.y * GRID_CELL_HEIGHT_PX };
-					createFilledTile(renderer, tile_pos, vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX), vec3(1, 0, 1));
-				}
-				vec2 start_pos = { final_path.front().x * GRID_CELL_WIDTH_PX, final_path.front().y * GRID_CELL_HEIGHT_PX };
-				createFilledTile(renderer, start_pos, vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX), vec3(0, 1, 0));
-
-				vec2 exit_pos = { final_path.back().x * GRID_CELL_WIDTH_PX, final_path.back().y * GRID_CELL_HEIGHT_PX };
-				createFilledTile(renderer, exit_pos, vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX), vec3(1, 0, 0));
-			}
-			else {
-				std::cout << "No valid path found, not displaying a final magenta path" << std::endl;
-			}
+			show_path_overlay(true);
 		}
 		else {
-			showpath = true;
-			clear_filled_tiles();
+			hide_path_overlay();
 		}
 		
 	}
@@ -1024,7 +996,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 		if (action == GLFW_RELEASE) {
 			// Toggle between playing and drawing modes
 			if (game_screen == GAME_SCREEN_ID::DRAWING) {
-				clear_filled_tiles();
+				hide_path_overlay();
 				game_screen = GAME_SCREEN_ID::PLAYING;
 				std::cout << "playing screen" << std::endl;
 
@@ -1032,6 +1004,12 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 				if (registry.invaders.entities.empty()) {
 					start_game();
 				}
+				else if (!flow_field.ready()) {
+					// the map was edited while paused, re-point the invaders already walking
+					flow_field.build();
+					if (!collect_spawn_tiles())
+						invaders_remaining = 0;
+				}
 			}
 			else if (game_screen == GAME_SCREEN_ID::PLAYING) {
 				clear_filled_tiles();
@@ -1098,13 +1076,10 @@ bool WorldSystem::load_level(const std::string& filename) {
 		return false;
 	}
 
-	std::vector<Entity> toRemove = registry.motions.entities;
-	for (Entity e : toRemove) {
-		if (!registry.selectables.has(e)) {
-			registry.remove_all_components_of(e);
-		}
-	}
-
+	// the optional "size W H" line can come anywhere, so read the tiles first and
+	// size the grids before placing them; levels without one are a single screen
+	MapGrid level_grid;
+	std::vector<ivec3> level_tiles;
 	std::string line;
 	while (std::getline(ifs, line)) {
 		std::stringstream ss(line);
@@ -1113,13 +1088,44 @@ bool WorldSystem::load_level(const std::string& filename) {
 		if (token == "tile") {
 			int tx, ty, tex_id;
 			ss >> tx >> ty >> tex_id;
-			float px = tx * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f;
-			float py = ty * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f;
-			createLevelTile(renderer, vec2(px, py), (TEXTURE_ASSET_ID)tex_id);
+			level_tiles.push_back(ivec3(tx, ty, tex_id));
+		}
+		else if (token == "size") {
+			int wide, high;
+			if (ss >> wide >> high) {
+				level_grid.wide = clamp(wide, 1, MAX_GRID_CELLS);
+				level_grid.high = clamp(high, 1, MAX_GRID_CELLS);
+			}
 		}
 	}
-
 	ifs.close();
+
+	std::vector<Entity> toRemove = registry.motions.entities;
+	for (Entity e : toRemove) {
+		if (!registry.selectables.has(e)) {
+			registry.remove_all_components_of(e);
+		}
+	}
+	map_grid = level_grid;
+	tile_grid.clear();
+	path_planner.invalidate();
+	path_hierarchy.invalidate();
+	flow_field.invalidate();
+	static_layer.invalidate();
+	coverage_map.invalidate();
+	move_camera(ivec2(0, 0), true);
+
+	// only cells that hold a tile get an entity, empty cells cost nothing
+	for (const ivec3& tile : level_tiles) {
+		if (!map_grid.in_bounds(ivec2(tile.x, tile.y)) || tile.z < 0 || tile.z >= texture_count) {
+			std::cout << "WARNING: skipped tile " << tile.x << " " << tile.y << " " << tile.z << ", outside the map or not a texture" << std::endl;
+			continue;
+		}
+		float px = tile.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f;
+		float py = tile.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f;
+		createLevelTile(renderer, vec2(px, py), (TEXTURE_ASSET_ID)tile.z);
+	}
+
 	std::cout << "Level loaded from " << filename << std::endl;
 	return true;
 }
@@ -1161,6 +1167,22 @@ bool WorldSystem::save_level(const std::string& filename) {
 	return true;
 }
 
+// whole cells only, so the screen-space grid lines stay on the cell borders
+void WorldSystem::move_camera(ivec2 cells, bool reset) {
+	vec2 camera = reset ? vec2(0.f) : renderer->camera;
+	camera += vec2(cells.x * GRID_CELL_WIDTH_PX, cells.y * GRID_CELL_HEIGHT_PX);
+
+	// the map may be smaller than the window, then it stays at the top left
+	vec2 max_camera = max(map_grid.size_px() - vec2(WINDOW_WIDTH_PX, WINDOW_HEIGHT_PX), vec2(0.f));
+	max_camera = floor(max_camera / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)) * vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX);
+	renderer->camera = clamp(camera, vec2(0.f), max_camera);
+}
+
+// the map cell under the mouse, through the camera
+ivec2 WorldSystem::mouse_cell() const {
+	return ivec2(floor((vec2(mouse_pos_x, mouse_pos_y) + renderer->camera) / vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX)));
+}
+
 void WorldSystem::on_mouse_move(vec2 mouse_position) {
 
 	mouse_pos_x = mouse_position.x;
@@ -1170,8 +1192,12 @@ void WorldSystem::on_mouse_move(vec2 mouse_position) {
 void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
 	if (action != GLFW_PRESS) return;
 
-	int tile_x = (int)(mouse_pos_x / GRID_CELL_WIDTH_PX);
-	int tile_y = (int)(mouse_pos_y / GRID_CELL_HEIGHT_PX);
+	// the tile selector and the top (text) row are in screen space, the map scrolls under the camera
+	int screen_tile_x = (int)(mouse_pos_x / GRID_CELL_WIDTH_PX);
+	int screen_tile_y = (int)(mouse_pos_y / GRID_CELL_HEIGHT_PX);
+	ivec2 map_cell = mouse_cell();
+	int tile_x = map_cell.x;
+	int tile_y = map_cell.y;
 
 	std::cout << "mouse position: " << mouse_pos_x << ", " << mouse_pos_y << std::endl;
 	std::cout << "mouse tile position: " << tile_x << ", " << tile_y << std::endl;
@@ -1180,7 +1206,7 @@ void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
 		for (Entity entity : registry.selectables.entities) {
 			Tile& tile = registry.tiles.get(entity);
 
-			if (tile.tx == tile_x && tile.ty == tile_y) {
+			if (tile.tx == screen_tile_x && tile.ty == screen_tile_y) {
 				drawing_tile = tile.tile_id;  
 				//std::cout << "Selected tile ID: " << (int)drawing_tile << "\n";
 				return;  
@@ -1189,7 +1215,7 @@ void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
 	}
 
 	if (game_screen == GAME_SCREEN_ID::PLAYING && button == GLFW_MOUSE_BUTTON_LEFT) {
-		if (tile_y > 0) {
+		if (screen_tile_y > 0 && map_grid.in_bounds(ivec2(tile_x, tile_y))) {
 			bool towerExists = false;
 			for (Entity e : registry.towers.entities) {
 				Motion& m = registry.motions.get(e);
@@ -1200,15 +1226,13 @@ void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
 					break;
 				}
 			}
-			bool tileExists = false;
-			for (Entity e : registry.tiles.entities) {
-				Tile& t = registry.tiles.get(e);
-				if (t.tx == tile_x && t.ty == tile_y) {
-					tileExists = true;
-					break;
+			bool tileExists = tile_grid.has(ivec2(tile_x, tile_y));
+			if (!towerExists && (!tileExists || mazing) && registry.towers.size() < 5) {
+				// mazing: a tower on a path tile walls it off, unless that cuts the start off from the exit
+				if (tileExists && !flow_field.block(ivec2(tile_x, tile_y))) {
+					std::cout << "INFO: tower rejected, it would block the only path to the exit" << std::endl;
+					return;
 				}
-			}
-			if (!towerExists && !tileExists && registry.towers.size() < 5) {
 				vec2 pos(tile_x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f,
 					tile_y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f);
 				createTower(renderer, pos);
@@ -1222,7 +1246,7 @@ void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
 
 
 	if (game_screen == GAME_SCREEN_ID::DRAWING) {
-		if (tile_y == 0) return;  
+		if (screen_tile_y == 0 || !map_grid.in_bounds(ivec2(tile_x, tile_y))) return;  
 
 		if (button == GLFW_MOUSE_BUTTON_LEFT) {
 			remove_tile(tile_x, tile_y);  
@@ -1232,19 +1256,25 @@ void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
 		if (button == GLFW_MOUSE_BUTTON_RIGHT || (button == GLFW_MOUSE_BUTTON_LEFT && shift_key_pressed)) {
 			remove_tile(tile_x, tile_y);  
 		}
+
+		// keep a shown path overlay live while painting, only the edited region is re-searched
+		if (!showpath)
+			show_path_overlay(false);
 	}
 }
 
 void WorldSystem::remove_tile(int x, int y) {
 	bool tile_removed = false;
-	for (Entity e : registry.tiles.entities) {
-		Tile& tile = registry.tiles.get(e);
-		if (tile.tx == x && tile.ty == y) {
-			registry.remove_all_components_of(e);
-			// std::cout << "Tile removed at (" << x << ", " << y << ")" << std::endl;
-			tile_removed = true;
-			break;
-		}
+	ivec2 cell(x, y);
+	if (tile_grid.has(cell)) {
+		registry.remove_all_components_of(tile_grid.entity_at(cell));
+		tile_grid.remove(cell);
+		// std::cout << "Tile removed at (" << x << ", " << y << ")" << std::endl;
+		tile_removed = true;
+		path_planner.tile_changed(cell);
+		path_hierarchy.tile_changed(cell);
+		flow_field.invalidate();
+		static_layer.invalidate();
 	}
 	if (!tile_removed) {
 		// std::cout << "No matching tile found at (" << x << ", " << y << ")" << std::endl;
@@ -1254,7 +1284,25 @@ void WorldSystem::remove_tile(int x, int y) {
 
 void WorldSystem::place_tile(int x, int y, TEXTURE_ASSET_ID tile_type) {
 	vec2 position = vec2(x * GRID_CELL_WIDTH_PX, y * GRID_CELL_HEIGHT_PX);
-	Entity new_tile = createLevelTile(renderer, position, tile_type);
+	createLevelTile(renderer, position, tile_type);
+	path_planner.tile_changed(ivec2(x, y));
+	path_hierarchy.tile_changed(ivec2(x, y));
+	flow_field.invalidate();
+	static_layer.invalidate();
+}
+
+// the start tiles the (built) flow field routes to an exit, in placement order
+bool WorldSystem::collect_spawn_tiles() {
+	spawn_tiles.clear();
+	next_spawn = 0;
+	for (size_t k = 0; k < tile_grid.start_count(); k++) {
+		ivec2 start_tile = tile_grid.start_at(k);
+		if (flow_field.reachable(start_tile))
+			spawn_tiles.push_back(start_tile);
+		else
+			std::cout << "WARNING: start tile (" << start_tile.x << ", " << start_tile.y << ") has no path to an exit, skipped" << std::endl;
+	}
+	return !spawn_tiles.empty();
 }
 
 void WorldSystem::start_game() {
@@ -1263,118 +1311,86 @@ void WorldSystem::start_game() {
 	glm::ivec2 start_tile, exit_tile;
 	if (!find_first_start_tile(start_tile) || !find_first_exit_tile(exit_tile)) {
 		std::cout << "ERROR: No valid start or exit tile found! No invader will spawn.\n";
+		spawn_tiles.clear();
+		invaders_remaining = 0;
 		return;
 	}
 
-
-	std::vector<glm::ivec2> path;
-	if (!find_path(path)) {
+	// one reverse BFS from all exits at once serves every start tile, instead of a path search per pair
+	flow_field.build();
+	if (!collect_spawn_tiles()) {
 		std::cout << "ERROR: No valid path found from start to exit! No invader will spawn.\n";
+		invaders_remaining = 0;
 		return;
 	}
-	ivec2 first_tile = path.front();
-
-	spawn_start_position = vec2((start_tile.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2.f) - GRID_CELL_WIDTH_PX,
-		(start_tile.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2.f) - GRID_CELL_HEIGHT_PX);
-
-	// Entity invader = createInvader(renderer, start_position);
-	/*Entity invader = createInvader(renderer, spawn_start_position);
-	WalkingPath& invader_path = registry.walkingPaths.emplace(invader);
-	invader_path.path = path;*/
 
 	invaders_remaining = 10 * (level + 1);
 	//invaders_remaining = 5; // for testing
 
-	spawn_path = path;
-
 	next_invader_spawn = 0.f;
 }
 
 
 
-bool WorldSystem::find_path_with_visitation(std::vector<ivec2>& path, std::unordered_set<ivec2>& visited) {
+void WorldSystem::show_path_overlay(bool from_scratch) {
+	clear_filled_tiles();
+
 	glm::ivec2 start_tile, exit_tile;
-	if (!this->find_first_start_tile(start_tile) || !this->find_first_exit_tile(exit_tile)) {
+	if (!find_first_start_tile(start_tile) || !find_first_exit_tile(exit_tile)) {
 		std::cout << "No valid start or exit tile found" << std::endl;
-		return false;
+		return;
 	}
-
-	/*std::cout << "Finding path with visitation from (" << start_tile.x << ", " << start_tile.y
-		<< ") to (" << exit_tile.x << ", " << exit_tile.y << ")" << std::endl;*/
-
-	std::unordered_set<glm::ivec2> closed_set;
-	std::unordered_map<glm::ivec2, glm::ivec2> parent_map;
-
-	std::priority_queue<Node, std::vector<Node>, std::function<bool(Node, Node)>> open_list(
-		[](const Node& a, const Node& b) { return a.get_score() > b.get_score(); }
-	);
-
-	// Start A* search.
-	open_list.emplace(start_tile, start_tile, 0, glm::distance(glm::vec2(start_tile), glm::vec2(exit_tile)));
-	parent_map[start_tile] = start_tile;
-
-	visited.clear();
-
-	while (!open_list.empty()) {
-		Node current = open_list.top();
-		open_list.pop();
-
-		closed_set.insert(current.position);
-		visited.insert(current.position);
-
-		if (current.position == exit_tile) {
-			path.clear();
-			glm::ivec2 step = exit_tile;
-			while (step != start_tile) {
-				path.push_back(step);
-				step = parent_map[step];  
-			}
-			path.push_back(start_tile);
-			std::reverse(path.begin(), path.end());
-			// std::cout << "Path found. Steps: " << path.size() << std::endl;
-			return true;
+	auto fill_tile = [this](ivec2 tile_coord, vec3 color) {
+		vec2 tile_pos = { tile_coord.x * GRID_CELL_WIDTH_PX, tile_coord.y * GRID_CELL_HEIGHT_PX };
+		createFilledTile(renderer, tile_pos, vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX), color);
+	};
+
+	// the tiles this (re)plan expanded are shaded blue, the path is drawn over them
+	auto shade_expanded = [&](ivec2 tile_coord) { fill_tile(tile_coord, vec3(0, 0, 1)); };
+
+	std::vector<glm::ivec2> final_path;
+	bool path_found = false;
+	if (map_grid.count() > PATH_HIERARCHY_MIN_CELLS) {
+		// LPA* keeps g and rhs for every cell of the map, large maps search over clusters
+		// instead and only the expanded entrances are shaded. final_path is just the
+		// waypoints then, each leg is refined into tiles only as it is drawn.
+		path_found = path_hierarchy.find_waypoints(start_tile, exit_tile, final_path, shade_expanded);
+		std::vector<ivec2> leg;
+		for (size_t i = 1; path_found && i < final_path.size(); i++) {
+			leg.clear();
+			path_found = path_hierarchy.refine(final_path[i - 1], final_path[i], leg);
+			// the last tile of a leg is the next waypoint, drawn below
+			for (size_t k = 0; path_found && k + 1 < leg.size(); k++)
+				fill_tile(leg[k], vec3(1, 0, 1));
 		}
+	}
+	else if (from_scratch) {
+		// a one-shot A* shows everything a full search looks at; the planner is settled
+		// quietly alongside, so the next edit is already an incremental repair
+		path_planner.reset(start_tile, exit_tile);
+		path_planner.plan(final_path);
+		path_found = path_search.find(start_tile, exit_tile, final_path, shade_expanded);
+	}
+	else {
+		if (!path_planner.matches(start_tile, exit_tile))
+			path_planner.reset(start_tile, exit_tile);
+		path_found = path_planner.plan(final_path, shade_expanded);
+	}
 
-		std::vector<glm::ivec2> neighbors = {
-			{ current.position.x,     current.position.y - 1 },
-			{ current.position.x,     current.position.y + 1 },
-			{ current.position.x - 1, current.position.y     },
-			{ current.position.x + 1, current.position.y     }
-		};
-
-		for (const glm::ivec2& neighbor : neighbors) {
-			if (closed_set.find(neighbor) != closed_set.end()) {
-				continue;
-			}
-				  
-			Tile* neighborTilePtr = nullptr;
-			Tile* currentTilePtr = nullptr;
-			for (Entity entity : registry.tiles.entities) {
-				Tile& tile = registry.tiles.get(entity);
-				if (tile.tx == neighbor.x && tile.ty == neighbor.y)
-					neighborTilePtr = &tile;
-				if (tile.tx == current.position.x && tile.ty == current.position.y)
-					currentTilePtr = &tile;
-				if (neighborTilePtr && currentTilePtr)
-					break;
-			}
-			if (!neighborTilePtr || !currentTilePtr) {
-				continue;
-			}
-			
-			glm::ivec2 direction = neighbor - current.position;
-			if (!canConnect(*currentTilePtr, *neighborTilePtr, direction)) {
-				continue;
-			}
-			uint g = current.G + 1;
-			uint h = glm::distance(glm::vec2(neighbor), glm::vec2(exit_tile));
-			open_list.emplace(neighbor, current.position, g, h);
-			parent_map[neighbor] = current.position;
-		}
+	if (path_found) {
+		for (const auto& tile_coord : final_path)
+			fill_tile(tile_coord, vec3(1, 0, 1));
+		fill_tile(final_path.front(), vec3(0, 1, 0));
+		fill_tile(final_path.back(), vec3(1, 0, 0));
+	}
+	else {
+		std::cout << "No valid path found, not displaying a final magenta path" << std::endl;
 	}
+}
 
-	std::cout << "no valid path" << std::endl;
-	return false;
+void WorldSystem::hide_path_overlay() {
+	showpath = true;
+	clear_filled_tiles();
 }
 
 void WorldSystem::clear_filled_tiles() {
@@ -13,6 +13,7 @@
 #include <SDL_mixer.h>
 
 #include "render_system.hpp"
+#include "pathing.hpp"
 
 #include <functional> // for std::hash
 #include <glm/vec2.hpp>
@@ -44,6 +45,7 @@ public:
 	bool showpath = true;
 	bool invader_respawns = false;
 	bool showfilledtiles = false;
+	bool mazing = false;	// towers may be placed on path tiles
 	WorldSystem();
 
 	// creates main window
@@ -98,7 +100,6 @@ public:
 	std::string world_level_filename = "level0.txt";
 	bool load_level(const std::string& filename);
 	bool save_level(const std::string& filename);
-	bool find_path(std::vector<ivec2>& path);
 
 	// A2: world level
 	bool find_first_start_tile(glm::ivec2& start_tile);
@@ -113,7 +114,6 @@ public:
 private:
 
 	// PhysicsSystem* physics_system = nullptr;
-	ivec2 startTile;
 	float mouse_pos_x = 0.0f;
 	float mouse_pos_y = 0.0f;
 	// float next_invader_spawn = 0;
@@ -121,14 +121,22 @@ private:
 	int score = 0;
 	bool validLevel = true;
 	int invaders_remaining = 0;
-	vec2 spawn_start_position;
-	std::vector<ivec2> spawn_path;
+	// every start tile with a route to an exit, invaders take turns between them
+	std::vector<ivec2> spawn_tiles;
+	size_t next_spawn = 0;
 	float next_invader_spawn = 0;
 
 	bool victory = false;
 
 	Tile* getTileAt(const glm::ivec2& coord);
 
+	// from-scratch search behind the path overlay (O)
+	PathSearch path_search;
+	// incremental search behind the path overlay while painting
+	PathPlanner path_planner;
+	// replaces path_planner behind the overlay on large maps
+	PathHierarchy path_hierarchy;
+
 	// to better support uses with track pads and macOS, holding SHIFT + LEFT-CLICK will be a right-click
 	bool shift_key_pressed = false;
 
@@ -140,19 +148,30 @@ private:
 	void on_mouse_move(vec2 pos);
 	void on_mouse_button_pressed(int button, int action, int mods);
 
+	// A2: scroll the window over the map by whole cells, reset puts it back at the top left
+	void move_camera(ivec2 cells, bool reset = false);
+	ivec2 mouse_cell() const;
+
 	// ADDED
 	void remove_tile(int x, int y);
 	void place_tile(int x, int y, TEXTURE_ASSET_ID tile_type);
 	void render_tile_selector();
 	void start_game();
-	bool canConnect(const Tile& current, const Tile& neighbor, const glm::ivec2& direction);
-
-	bool find_path_with_visitation(std::vector<glm::ivec2>& path, std::unordered_set<glm::ivec2>& visited);
+	bool collect_spawn_tiles();
 	void clear_filled_tiles();
 
+	// A2: path overlay (O) in the drawing screen, kept up to date while painting
+	void show_path_overlay(bool from_scratch);
+	void hide_path_overlay();
+
 	// restart level
 	void restart_game();
 
+	// collision handlers, dispatched by layer pair from handle_collisions
+	void on_projectile_hit(Entity invader, Entity projectile);
+	void on_tower_reached(Entity invader, Entity tower);
+	void damage_invader(Entity invader, int damage);
+
 	// OpenGL window handle
 	GLFWwindow* window;
 